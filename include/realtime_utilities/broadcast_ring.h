@@ -0,0 +1,183 @@
+#ifndef REALTIME_UTILITIES_BROADCAST_RING_H
+#define REALTIME_UTILITIES_BROADCAST_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+#include <realtime_utilities/circular_buffer_fixed.h>
+
+namespace realtime_utilities
+{
+
+// Single-producer / multi-consumer broadcast ring (disruptor style).
+//
+// Every registered consumer owns a sequence number and sees every published
+// element, independently of the others: reading does not remove the element
+// for anybody else.
+//
+// Gated mode (default): publish() fails when the slowest consumer has not read
+// the slot that would be overwritten, so no consumer ever loses a sample.
+//
+// Lossy mode: the producer never waits. A consumer that lags more than N
+// samples behind skips to the oldest available element, and the number of
+// skipped samples is reported by lost(). Slots are guarded by a per-slot
+// sequence lock, hence the elements must be trivially copyable.
+template <typename T, std::size_t N, std::size_t MaxConsumers = 8, bool Lossy = false>
+class broadcast_ring
+{
+  static_assert(is_power_of_two(N), "broadcast_ring capacity must be a power of two");
+  static_assert(!Lossy || std::is_trivially_copyable<T>::value, "lossy broadcast_ring elements must be trivially copyable");
+
+public:
+  typedef int consumer_id;
+
+  broadcast_ring() : head_(0), gate_(0)
+  {
+    for (auto& s : slots_)
+      s.seq.store(0, std::memory_order_relaxed);
+    for (auto& c : consumers_)
+    {
+      c.seq.store(0, std::memory_order_relaxed);
+      c.lost.store(0, std::memory_order_relaxed);
+      c.active.store(false, std::memory_order_relaxed);
+    }
+  }
+  broadcast_ring(const broadcast_ring&) = delete;
+  broadcast_ring& operator=(const broadcast_ring&) = delete;
+
+  // A new consumer starts from the next published element.
+  // Returns -1 when all the MaxConsumers slots are taken.
+  consumer_id add_consumer()
+  {
+    for (std::size_t i = 0; i < MaxConsumers; i++)
+    {
+      bool expected = false;
+      if (!consumers_[i].active.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+        continue;
+      // until the store below the producer gates on a stale (older) sequence,
+      // which is conservative
+      consumers_[i].lost.store(0, std::memory_order_relaxed);
+      consumers_[i].seq.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+      return static_cast<consumer_id>(i);
+    }
+    return -1;
+  }
+  void remove_consumer(consumer_id id)
+  {
+    consumers_[id].active.store(false, std::memory_order_release);
+  }
+
+  // producer side
+  bool publish(const T& item)
+  {
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    if (!Lossy && head - gate_ >= N)
+    {
+      gate_ = min_consumer_seq(head);
+      if (head - gate_ >= N)
+        return false;
+    }
+    slot& s = slots_[head & mask];
+    s.seq.store(2 * head + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s.data = item;
+    s.seq.store(2 * head + 2, std::memory_order_release);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer side
+  std::size_t available(consumer_id id) const
+  {
+    return head_.load(std::memory_order_acquire) - consumers_[id].seq.load(std::memory_order_relaxed);
+  }
+  bool read(consumer_id id, T& item)
+  {
+    return read(id, &item, 1) == 1;
+  }
+  // copy up to max elements, oldest first, and return how many were read
+  std::size_t read(consumer_id id, T* items, std::size_t max)
+  {
+    cursor& c = consumers_[id];
+    uint64_t seq = c.seq.load(std::memory_order_relaxed);
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    std::size_t n = 0;
+    while (n < max && seq < head)
+    {
+      const slot& s = slots_[seq & mask];
+      if (!Lossy)
+      {
+        items[n++] = s.data;
+        seq++;
+        continue;
+      }
+      const uint64_t before = s.seq.load(std::memory_order_acquire);
+      if (before == 2 * seq + 2)
+      {
+        items[n] = s.data;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s.seq.load(std::memory_order_relaxed) == before)
+        {
+          n++;
+          seq++;
+          continue;
+        }
+      }
+      // the producer lapped us: restart from the oldest slot still valid
+      const uint64_t oldest = head_.load(std::memory_order_acquire) - N + 1;
+      if (oldest > seq)
+      {
+        c.lost.fetch_add(oldest - seq, std::memory_order_relaxed);
+        seq = oldest;
+      }
+    }
+    c.seq.store(seq, std::memory_order_release);
+    return n;
+  }
+  uint64_t lost(consumer_id id) const
+  {
+    return consumers_[id].lost.load(std::memory_order_relaxed);
+  }
+
+  constexpr std::size_t capacity() const
+  {
+    return N;
+  }
+
+private:
+  static constexpr uint64_t mask = N - 1;
+
+  uint64_t min_consumer_seq(uint64_t head) const
+  {
+    uint64_t ret = head;
+    for (const auto& c : consumers_)
+    {
+      if (c.active.load(std::memory_order_acquire))
+        ret = std::min(ret, c.seq.load(std::memory_order_acquire));
+    }
+    return ret;
+  }
+
+  struct slot
+  {
+    std::atomic<uint64_t> seq;
+    T                     data;
+  };
+  struct alignas(cache_line_size) cursor
+  {
+    std::atomic<uint64_t> seq;
+    std::atomic<uint64_t> lost;
+    std::atomic<bool>     active;
+  };
+
+  alignas(cache_line_size) std::atomic<uint64_t> head_;
+  uint64_t gate_;  // producer-local cache of the slowest consumer sequence
+  cursor consumers_[MaxConsumers];
+  alignas(cache_line_size) slot slots_[N];
+};
+
+}  // namespace realtime_utilities
+
+#endif  // REALTIME_UTILITIES_BROADCAST_RING_H
@@ -2,6 +2,8 @@
 #define REALTIME_UTILITIES_CIRCULAR_BUFFER_H
 
 #include <mutex>
+#include <utility>
+#include <boost/noncopyable.hpp>
 #include <boost/thread.hpp>
 #include <boost/circular_buffer.hpp>
 #include <boost/thread/condition.hpp>
@@ -27,12 +29,45 @@ public:
     cb.push_back(imdata);
     buffer_not_empty.notify_one();
   }
+  virtual void push_back(T&& imdata)
+  {
+    lock lk(monitor);
+    cb.push_back(std::move(imdata));
+    buffer_not_empty.notify_one();
+  }
+  // insert a burst of elements with a single lock and a single wake-up
+  template <typename InputIterator>
+  void push_back(InputIterator first, InputIterator last)
+  {
+    lock lk(monitor);
+    if (first == last)
+      return;
+    for (; first != last; ++first)
+      cb.push_back(*first);
+    buffer_not_empty.notify_all();
+  }
+  // boost::circular_buffer has no in-place construction: the element is
+  // built outside the lock and moved in
+  template <typename... Args>
+  void emplace_back(Args&&... args)
+  {
+    T imdata(std::forward<Args>(args)...);
+    lock lk(monitor);
+    cb.push_back(std::move(imdata));
+    buffer_not_empty.notify_one();
+  }
   virtual void push_front(const T& imdata)
   {
     lock lk(monitor);
     cb.push_front(imdata);
     buffer_not_empty.notify_one();
   }
+  virtual void push_front(T&& imdata)
+  {
+    lock lk(monitor);
+    cb.push_front(std::move(imdata));
+    buffer_not_empty.notify_one();
+  }
   virtual const T& front()
   {
     lock lk(monitor);
@@ -177,7 +212,7 @@ T max(const boost::circular_buffer<T>& cb)
 template< typename T>
 T min(const boost::circular_buffer<T>& cb)
 {
-  T ret = 0;
+  T ret = cb.empty() ? T(0) : cb.front();
   for (auto const & element : cb)
   {
     ret = std::min(element, ret);
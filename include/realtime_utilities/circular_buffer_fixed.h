@@ -0,0 +1,198 @@
+#ifndef REALTIME_UTILITIES_CIRCULAR_BUFFER_FIXED_H
+#define REALTIME_UTILITIES_CIRCULAR_BUFFER_FIXED_H
+
+#include <new>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/condition.hpp>
+
+namespace realtime_utilities
+{
+
+#if !defined(REALTIME_UTILITIES_CACHE_LINE_SIZE)
+#define REALTIME_UTILITIES_CACHE_LINE_SIZE 64
+#endif
+
+constexpr std::size_t cache_line_size = REALTIME_UTILITIES_CACHE_LINE_SIZE;
+
+constexpr bool is_power_of_two(std::size_t n)
+{
+  return n != 0 && (n & (n - 1)) == 0;
+}
+
+// Thread safe circular buffer with compile-time capacity.
+//
+// Same semantic of circ_buffer (push on a full buffer overwrites the oldest
+// element, front()/back() block until an element is available), but the
+// storage is inline and cache-line aligned, so the buffer never touches the
+// heap. Declared as a member (or static) of an object that exists before
+// rt_main_init(), its pages are locked by mlockall() and the RT thread gets
+// neither allocations nor page faults from it.
+template <typename T, std::size_t N>
+class circ_buffer_fixed : private boost::noncopyable
+{
+  static_assert(is_power_of_two(N), "circ_buffer_fixed capacity must be a power of two");
+
+public:
+  typedef boost::mutex::scoped_lock lock;
+
+  circ_buffer_fixed() : head_(0), size_(0) {}
+  virtual ~circ_buffer_fixed()
+  {
+    clear();
+  }
+
+  virtual void push_back(const T& imdata)
+  {
+    lock lk(monitor);
+    emplace_back_unlocked(imdata);
+    buffer_not_empty.notify_one();
+  }
+  virtual void push_back(T&& imdata)
+  {
+    lock lk(monitor);
+    emplace_back_unlocked(std::move(imdata));
+    buffer_not_empty.notify_one();
+  }
+  // insert a burst of elements with a single lock and a single wake-up
+  template <typename InputIterator>
+  void push_back(InputIterator first, InputIterator last)
+  {
+    lock lk(monitor);
+    if (first == last)
+      return;
+    for (; first != last; ++first)
+      emplace_back_unlocked(*first);
+    buffer_not_empty.notify_all();
+  }
+  template <typename... Args>
+  void emplace_back(Args&&... args)
+  {
+    lock lk(monitor);
+    emplace_back_unlocked(std::forward<Args>(args)...);
+    buffer_not_empty.notify_one();
+  }
+  virtual void push_front(const T& imdata)
+  {
+    lock lk(monitor);
+    emplace_front_unlocked(imdata);
+    buffer_not_empty.notify_one();
+  }
+  virtual void push_front(T&& imdata)
+  {
+    lock lk(monitor);
+    emplace_front_unlocked(std::move(imdata));
+    buffer_not_empty.notify_one();
+  }
+  virtual const T& front()
+  {
+    lock lk(monitor);
+    while (size_ == 0)
+      buffer_not_empty.wait(lk);
+    return slot(head_);
+  }
+  virtual const T& back()
+  {
+    lock lk(monitor);
+    while (size_ == 0)
+      buffer_not_empty.wait(lk);
+    return slot(head_ + size_ - 1);
+  }
+
+  virtual void pop_front()
+  {
+    lock lk(monitor);
+    if (size_ == 0)
+      return;
+    slot(head_).~T();
+    head_ = (head_ + 1) & mask;
+    size_--;
+  }
+
+  virtual void clear()
+  {
+    lock lk(monitor);
+    for (std::size_t i = 0; i < size_; i++)
+      slot(head_ + i).~T();
+    head_ = 0;
+    size_ = 0;
+  }
+
+  virtual int size()
+  {
+    lock lk(monitor);
+    return size_;
+  }
+
+  constexpr std::size_t capacity() const
+  {
+    return N;
+  }
+
+  virtual bool empty()
+  {
+    lock lk(monitor);
+    return size_ == 0;
+  }
+
+  virtual bool full()
+  {
+    lock lk(monitor);
+    return size_ == N;
+  }
+
+protected:
+  static constexpr std::size_t mask = N - 1;
+
+  void* address(std::size_t i)
+  {
+    return &data_[i & mask];
+  }
+  T& slot(std::size_t i)
+  {
+    return *reinterpret_cast<T*>(address(i));
+  }
+
+  // a full buffer overwrites the oldest (newest, for the front) element
+  template <typename... Args>
+  void emplace_back_unlocked(Args&&... args)
+  {
+    if (size_ == N)
+    {
+      slot(head_).~T();
+      head_ = (head_ + 1) & mask;
+      size_--;
+    }
+    new (address(head_ + size_)) T(std::forward<Args>(args)...);
+    size_++;
+  }
+  template <typename... Args>
+  void emplace_front_unlocked(Args&&... args)
+  {
+    if (size_ == N)
+    {
+      slot(head_ + size_ - 1).~T();
+      size_--;
+    }
+    head_ = (head_ - 1) & mask;
+    new (address(head_)) T(std::forward<Args>(args)...);
+    size_++;
+  }
+
+private:
+  typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+  alignas(cache_line_size) storage data_[N];
+  std::size_t head_;
+  std::size_t size_;
+  boost::condition buffer_not_empty;
+  mutable boost::mutex monitor;
+};
+
+}  // namespace realtime_utilities
+
+#endif  // REALTIME_UTILITIES_CIRCULAR_BUFFER_FIXED_H
@@ -0,0 +1,164 @@
+#ifndef REALTIME_UTILITIES_CIRCULAR_BUFFER_SHM_H
+#define REALTIME_UTILITIES_CIRCULAR_BUFFER_SHM_H
+
+#include <new>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <boost/noncopyable.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <realtime_utilities/spsc_ring.h>
+
+namespace realtime_utilities
+{
+
+// Circular buffer living in a named shared memory segment.
+//
+// The SERVER creates (and at destruction removes) the segment, the CLIENT
+// attaches to an existing one. The ring is lock-free for one producer and one
+// consumer, which may live in different processes: the RT process pushes
+// logs/statistics and an external process, pinned on a housekeeping core,
+// drains them. push_back() never blocks: when the consumer lags behind the
+// sample is dropped and counted.
+template <typename T, std::size_t N>
+class circ_buffer_shm : private boost::noncopyable
+{
+public:
+  enum AccessMode { SERVER, CLIENT };
+
+  circ_buffer_shm(const std::string& name, const AccessMode& mode) noexcept(false)
+    : name_(name), access_mode_(mode), segment_(nullptr)
+  {
+    boost::interprocess::permissions permissions(0677);
+    if (access_mode_ == SERVER)
+    {
+      mode_t old_umask = umask(0);
+      shared_memory_ = boost::interprocess::shared_memory_object(boost::interprocess::create_only, name_.c_str(), boost::interprocess::read_write, permissions);
+      umask(old_umask);
+
+      shared_memory_.truncate(sizeof(Segment));
+      shared_map_ = boost::interprocess::mapped_region(shared_memory_, boost::interprocess::read_write);
+      segment_ = new (shared_map_.get_address()) Segment();
+      segment_->magic.store(magic_number, std::memory_order_release);
+    }
+    else
+    {
+      shared_memory_ = boost::interprocess::shared_memory_object(boost::interprocess::open_only, name_.c_str(), boost::interprocess::read_write);
+      shared_map_    = boost::interprocess::mapped_region(shared_memory_, boost::interprocess::read_write);
+      if (shared_map_.get_size() < sizeof(Segment))
+      {
+        throw std::runtime_error("circ_buffer_shm '" + name_ + "': segment too small, type or capacity mismatch.");
+      }
+      segment_ = static_cast<Segment*>(shared_map_.get_address());
+      if (segment_->magic.load(std::memory_order_acquire) != magic_number
+          || segment_->element_size != sizeof(T) || segment_->capacity != N)
+      {
+        throw std::runtime_error("circ_buffer_shm '" + name_ + "': segment not initialized, or type or capacity mismatch.");
+      }
+    }
+  }
+
+  virtual ~circ_buffer_shm()
+  {
+    if (access_mode_ == SERVER)
+    {
+      segment_->~Segment();
+      boost::interprocess::shared_memory_object::remove(name_.c_str());
+    }
+  }
+
+  // producer side
+  bool push_back(const T& imdata)
+  {
+    if (segment_->ring.push(imdata))
+      return true;
+    segment_->dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  // consumer side, circ_buffer-like: front() and back() wait (yielding,
+  // there is no condition variable across the processes) until an item is
+  // available, pop_front() does nothing on an empty buffer
+  const T& front() const
+  {
+    const T* item;
+    while ((item = segment_->ring.front()) == nullptr)
+      std::this_thread::yield();
+    return *item;
+  }
+  const T& back() const
+  {
+    const T* item;
+    while ((item = segment_->ring.back()) == nullptr)
+      std::this_thread::yield();
+    return *item;
+  }
+  void pop_front()
+  {
+    segment_->ring.pop();
+  }
+
+  // consumer side, non blocking: false if the buffer is empty
+  bool pop_front(T& imdata)
+  {
+    return segment_->ring.pop(imdata);
+  }
+  void clear()
+  {
+    segment_->ring.clear();
+  }
+
+  int size() const
+  {
+    return segment_->ring.size();
+  }
+  bool empty() const
+  {
+    return segment_->ring.empty();
+  }
+  bool full() const
+  {
+    return segment_->ring.full();
+  }
+  constexpr std::size_t capacity() const
+  {
+    return N;
+  }
+  uint64_t dropped() const
+  {
+    return segment_->dropped.load(std::memory_order_relaxed);
+  }
+
+  const std::string& getName() const
+  {
+    return name_;
+  }
+
+private:
+  static constexpr uint64_t magic_number = 0x5254434253484d31ull;  // "RTCBSHM1"
+
+  struct Segment
+  {
+    std::atomic<uint64_t> magic;
+    uint64_t              element_size;
+    uint64_t              capacity;
+    std::atomic<uint64_t> dropped;
+    spsc_ring<T, N>       ring;
+
+    Segment() : magic(0), element_size(sizeof(T)), capacity(N), dropped(0) {}
+  };
+
+  const std::string                         name_;
+  const AccessMode                          access_mode_;
+  boost::interprocess::shared_memory_object shared_memory_;
+  boost::interprocess::mapped_region        shared_map_;
+  Segment*                                  segment_;
+};
+
+}  // namespace realtime_utilities
+
+#endif  // REALTIME_UTILITIES_CIRCULAR_BUFFER_SHM_H
@@ -0,0 +1,267 @@
+#ifndef REALTIME_UTILITIES_CONCURRENT_VECTOR_H
+#define REALTIME_UTILITIES_CONCURRENT_VECTOR_H
+
+#include <atomic>
+#include <new>
+#include <memory>
+#include <cstddef>
+#include <utility>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <realtime_utilities/circular_buffer_fixed.h>
+
+namespace realtime_utilities
+{
+
+// Append-only vector for concurrent writers and lock-free readers.
+//
+// Storage is split in segments whose size doubles (FirstSegment,
+// 2*FirstSegment, ...) and that are never moved, so references and iterators
+// stay valid while other threads push_back(). Writers claim a slot with an
+// atomic counter, construct the element and set the ready flag of the slot;
+// then every writer advances size() over the ready slots that follow it.
+// Writers never wait for each other: a preempted writer only delays the
+// visibility of the later elements, which the writer publishes when it
+// resumes. Readers always see a contiguous prefix of fully constructed
+// elements.
+//
+// The segment of a slot is allocated before the slot is claimed, and an
+// element whose constructor may throw is built in a temporary and then moved
+// in place (the move constructor must not throw): an exception leaves the
+// vector unchanged. Appending may allocate a new segment: call reserve()
+// beforehand to keep allocations out of the RT threads.
+template <class T, std::size_t FirstSegment = 16>
+class concurrent_vector
+{
+  static_assert(is_power_of_two(FirstSegment), "concurrent_vector first segment must be a power of two");
+
+public:
+  typedef T           value_type;
+  typedef std::size_t size_type;
+
+  class const_iterator
+  {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T                         value_type;
+    typedef std::ptrdiff_t            difference_type;
+    typedef const T*                  pointer;
+    typedef const T&                  reference;
+
+    const_iterator() : v_(nullptr), i_(0) {}
+    const_iterator(const concurrent_vector* v, size_type i) : v_(v), i_(i) {}
+    reference operator*() const  { return (*v_)[i_]; }
+    pointer   operator->() const { return &(*v_)[i_]; }
+    const_iterator& operator++()    { ++i_; return *this; }
+    const_iterator  operator++(int) { const_iterator ret(*this); ++i_; return ret; }
+    bool operator==(const const_iterator& rhs) const { return i_ == rhs.i_; }
+    bool operator!=(const const_iterator& rhs) const { return i_ != rhs.i_; }
+
+  private:
+    const concurrent_vector* v_;
+    size_type                i_;
+  };
+
+  concurrent_vector() : reserved_(0), size_(0)
+  {
+    for (auto& s : segments_)
+      s.store(nullptr, std::memory_order_relaxed);
+  }
+  explicit concurrent_vector(size_type n) : concurrent_vector()
+  {
+    reserve(n);
+  }
+  concurrent_vector(const concurrent_vector&) = delete;
+  concurrent_vector& operator=(const concurrent_vector&) = delete;
+
+  ~concurrent_vector()
+  {
+    const size_type n = size_.load(std::memory_order_acquire);
+    for (size_type i = 0; i < n; i++)
+      (*this)[i].~T();
+    for (size_type k = 0; k < max_segments; k++)
+    {
+      slot* s = segments_[k].load(std::memory_order_relaxed);
+      if (s)
+        release(s, segment_size(k));
+    }
+  }
+
+  // allocate the segments needed to store n elements
+  void reserve(size_type n)
+  {
+    if (n == 0)
+      return;
+    const size_type last = segment_of(n - 1);
+    for (size_type k = 0; k <= last; k++)
+      segment(k);
+  }
+
+  // returns the index of the new element
+  size_type push_back(const T& item)
+  {
+    return emplace_back(item);
+  }
+  size_type push_back(T&& item)
+  {
+    return emplace_back(std::move(item));
+  }
+  template <typename... Args>
+  size_type emplace_back(Args&&... args)
+  {
+    return emplace(std::integral_constant<bool, std::is_nothrow_constructible<T, Args&&...>::value>(), std::forward<Args>(args)...);
+  }
+
+  size_type size() const
+  {
+    return size_.load(std::memory_order_acquire);
+  }
+  bool empty() const
+  {
+    return size() == 0;
+  }
+
+  // no bound check: i must be lower than a previously read size()
+  T& operator[](size_type i)
+  {
+    return slot_at(i).value();
+  }
+  const T& operator[](size_type i) const
+  {
+    return const_cast<concurrent_vector*>(this)->slot_at(i).value();
+  }
+  const T& at(size_type i) const
+  {
+    if (i >= size())
+      throw std::out_of_range("concurrent_vector::at");
+    return (*this)[i];
+  }
+
+  // the range is frozen at the size read by end()
+  const_iterator begin() const
+  {
+    return const_iterator(this, 0);
+  }
+  const_iterator end() const
+  {
+    return const_iterator(this, size());
+  }
+
+private:
+  static constexpr size_type max_segments = 48;
+
+  struct slot
+  {
+    slot() : ready(false) {}
+    T& value()
+    {
+      return *reinterpret_cast<T*>(&storage);
+    }
+    std::atomic<bool>                                         ready;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+  };
+
+  // the constructor cannot throw: build the element in place
+  template <typename... Args>
+  size_type emplace(std::true_type, Args&&... args)
+  {
+    const size_type i = claim();
+    new (&slot_at(i).storage) T(std::forward<Args>(args)...);
+    publish(i);
+    return i;
+  }
+  // it can: build it before claiming the slot, then move it in place
+  template <typename... Args>
+  size_type emplace(std::false_type, Args&&... args)
+  {
+    static_assert(std::is_nothrow_move_constructible<T>::value,
+                  "concurrent_vector elements need a nothrow constructor or a nothrow move constructor");
+    T item(std::forward<Args>(args)...);
+    const size_type i = claim();
+    new (&slot_at(i).storage) T(std::move(item));
+    publish(i);
+    return i;
+  }
+
+  // returns a slot index whose segment is already allocated
+  size_type claim()
+  {
+    size_type i = reserved_.load(std::memory_order_relaxed);
+    do
+    {
+      segment(segment_of(i));
+    } while (!reserved_.compare_exchange_weak(i, i + 1, std::memory_order_relaxed, std::memory_order_relaxed));
+    return i;
+  }
+
+  // mark slot i ready and advance size_ over the ready slots. The ready
+  // store and the size_ read here, and the size_ CAS and the ready read of
+  // a writer that is advancing, are sequentially consistent: either this
+  // writer sees size_ reach i, or the other one sees slot i ready.
+  void publish(size_type i)
+  {
+    slot_at(i).ready.store(true, std::memory_order_seq_cst);
+    size_type n = size_.load(std::memory_order_seq_cst);
+    for (slot* s = find(n); s && s->ready.load(std::memory_order_seq_cst); s = find(n))
+    {
+      if (size_.compare_exchange_weak(n, n + 1, std::memory_order_seq_cst, std::memory_order_seq_cst))
+        n++;
+    }
+  }
+
+  slot& slot_at(size_type i)
+  {
+    const size_type k = segment_of(i);
+    return segments_[k].load(std::memory_order_acquire)[i + FirstSegment - segment_size(k)];
+  }
+  // nullptr if the segment of slot i is not allocated yet
+  slot* find(size_type i)
+  {
+    const size_type k = segment_of(i);
+    slot* s = segments_[k].load(std::memory_order_acquire);
+    return s ? s + (i + FirstSegment - segment_size(k)) : nullptr;
+  }
+
+  static size_type floor_log2(size_type n)
+  {
+    return 8 * sizeof(unsigned long long) - 1 - __builtin_clzll(n);
+  }
+  static size_type segment_of(size_type i)
+  {
+    return floor_log2(i + FirstSegment) - floor_log2(FirstSegment);
+  }
+  static size_type segment_size(size_type k)
+  {
+    return FirstSegment << k;
+  }
+
+  slot* segment(size_type k)
+  {
+    slot* s = segments_[k].load(std::memory_order_acquire);
+    if (s)
+      return s;
+    slot* fresh = allocator_.allocate(segment_size(k));
+    for (size_type j = 0; j < segment_size(k); j++)
+      new (fresh + j) slot();
+    if (segments_[k].compare_exchange_strong(s, fresh, std::memory_order_acq_rel))
+      return fresh;
+    release(fresh, segment_size(k));
+    return s;
+  }
+  void release(slot* s, size_type n)
+  {
+    for (size_type j = 0; j < n; j++)
+      s[j].~slot();
+    allocator_.deallocate(s, n);
+  }
+
+  std::allocator<slot> allocator_;
+  std::atomic<slot*>   segments_[max_segments];
+  alignas(cache_line_size) std::atomic<size_type> reserved_;
+  alignas(cache_line_size) std::atomic<size_type> size_;
+};
+
+}  // namespace realtime_utilities
+
+#endif  // REALTIME_UTILITIES_CONCURRENT_VECTOR_H
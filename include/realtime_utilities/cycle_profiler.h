@@ -0,0 +1,184 @@
+#ifndef REALTIME_UTILITIES_CYCLE_PROFILER_H
+#define REALTIME_UTILITIES_CYCLE_PROFILER_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <realtime_utilities/histogram.h>
+#include <realtime_utilities/tsc_clock.h>
+
+namespace realtime_utilities
+{
+
+/**
+ * @class CycleProfiler
+ *
+ * Splits the cycle of a periodic loop in named phases, and tells how much of
+ * the period budget each of them takes:
+ *
+ *   CycleProfiler prof(0.00025);
+ *   auto read = prof.addPhase("io read");
+ *   auto est  = prof.addPhase("estimation");
+ *   auto ctrl = prof.addPhase("control");
+ *   auto wrt  = prof.addPhase("io write");
+ *   while (...)
+ *   {
+ *     wait_rest_of_period();
+ *     prof.begin();
+ *     ...  prof.mark(read);
+ *     ...  prof.mark(est);
+ *     ...  prof.mark(ctrl);
+ *     ...  prof.mark(wrt);
+ *     prof.end();
+ *   }
+ *
+ * mark(phase) closes the phase started at the previous begin()/mark(): a
+ * tsc_clock read and a histogram update. end() records the busy time of
+ * the cycle and its slack against the period; in the cycles whose busy time
+ * exceeds the period, each phase also accumulates its duration apart, so
+ * that the report shows which phase eats the margin when the loop overruns.
+ *
+ * Phases are added before the loop starts; begin/mark/end are called by the
+ * loop thread only, the statistics can be read by any thread.
+ */
+class CycleProfiler
+{
+public:
+  typedef std::shared_ptr<CycleProfiler> Ptr;
+  typedef std::shared_ptr<CycleProfiler const> ConstPtr;
+  typedef std::size_t PhaseId;
+
+  struct PhaseStatistics
+  {
+    std::string        name;
+    histogram::summary duration;       // [ns]
+    double             share;          // mean duration / period
+    double             overrun_mean;   // [ns] mean duration in the overrun cycles
+  };
+  struct Statistics
+  {
+    double                       period;    // [s]
+    std::vector<PhaseStatistics> phases;
+    histogram::summary           busy;      // [ns] begin() to end()
+    histogram::summary           slack;     // [ns] period - busy, 0 when overrun
+    std::size_t                  cycles;
+    std::size_t                  overruns;
+  };
+
+  explicit CycleProfiler(const double& period)
+    : period_(period), period_ns_(int64_t(period * 1e9)), cycle_begin_(0), last_mark_(0), overrun_cycles_(0)
+  {
+    tsc_clock::calibrate();
+  }
+  CycleProfiler(const CycleProfiler&) = delete;
+  CycleProfiler& operator=(const CycleProfiler&) = delete;
+
+  PhaseId addPhase(const std::string& name)
+  {
+    phases_.emplace_back(new phase(name));
+    current_.push_back(0);
+    return phases_.size() - 1;
+  }
+
+  void begin()
+  {
+    cycle_begin_ = last_mark_ = tsc_clock::ticks();
+    for (int64_t& c : current_)
+      c = 0;
+  }
+  void mark(const PhaseId& id)
+  {
+    const int64_t now = tsc_clock::ticks();
+    const int64_t ns = to_ns(now - last_mark_);
+    last_mark_ = now;
+    phases_[id]->duration.record(ns);
+    current_[id] += ns;
+  }
+  void end()
+  {
+    const int64_t busy = to_ns(tsc_clock::ticks() - cycle_begin_);
+    busy_.record(busy);
+    slack_.record(busy < period_ns_ ? period_ns_ - busy : 0);
+    if (busy > period_ns_)
+    {
+      overrun_cycles_.store(overrun_cycles_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      for (std::size_t i = 0; i < phases_.size(); i++)
+      {
+        std::atomic<int64_t>& sum = phases_[i]->overrun_ns;
+        sum.store(sum.load(std::memory_order_relaxed) + current_[i], std::memory_order_relaxed);
+      }
+    }
+  }
+
+  Statistics getStatistics() const
+  {
+    Statistics ret;
+    ret.period   = period_;
+    ret.busy     = busy_.summarize();
+    ret.slack    = slack_.summarize();
+    ret.cycles   = ret.busy.count;
+    ret.overruns = overrun_cycles_.load(std::memory_order_relaxed);
+    for (const auto& p : phases_)
+    {
+      PhaseStatistics s;
+      s.name         = p->name;
+      s.duration     = p->duration.summarize();
+      s.share        = period_ns_ > 0 ? s.duration.mean / double(period_ns_) : 0.0;
+      s.overrun_mean = ret.overruns > 0 ? double(p->overrun_ns.load(std::memory_order_relaxed)) / double(ret.overruns) : 0.0;
+      ret.phases.push_back(s);
+    }
+    return ret;
+  }
+
+  void reset()
+  {
+    for (auto& p : phases_)
+    {
+      p->duration.reset();
+      p->overrun_ns.store(0, std::memory_order_relaxed);
+    }
+    busy_.reset();
+    slack_.reset();
+    overrun_cycles_.store(0, std::memory_order_relaxed);
+  }
+
+  std::size_t size() const
+  {
+    return phases_.size();
+  }
+
+private:
+  struct phase
+  {
+    explicit phase(const std::string& n) : name(n), overrun_ns(0) {}
+    const std::string    name;
+    histogram            duration;
+    std::atomic<int64_t> overrun_ns;
+  };
+
+  static int64_t to_ns(const int64_t ticks)
+  {
+    return int64_t(1e9 * tsc_clock::to_seconds(ticks));
+  }
+
+  const double                        period_;
+  const int64_t                       period_ns_;
+  std::vector<std::unique_ptr<phase>> phases_;
+
+  // loop thread state
+  int64_t                             cycle_begin_;
+  int64_t                             last_mark_;
+  std::vector<int64_t>                current_;
+
+  histogram                           busy_;
+  histogram                           slack_;
+  std::atomic<std::size_t>            overrun_cycles_;
+};
+
+typedef CycleProfiler::Ptr CycleProfilerPtr;
+typedef CycleProfiler::ConstPtr CycleProfilerConstPtr;
+
+}  // namespace realtime_utilities
+
+#endif  // REALTIME_UTILITIES_CYCLE_PROFILER_H
@@ -2,6 +2,7 @@
 #define REALTIME_UTILITIES__DIAGNOSTICS_INTERFACE__H
 
 #include <memory>
+#include <deque>
 #include <ctime>
 #include <chrono>
 #include <algorithm>
@@ -11,18 +12,35 @@
 #include <diagnostic_msgs/DiagnosticArray.h>
 #include <diagnostic_updater/DiagnosticStatusWrapper.h>
 #include <realtime_utilities/time_span_tracker.h>
+#include <realtime_utilities/cycle_profiler.h>
+#include <realtime_utilities/lockfree_queue.h>
+
+#if !defined(REALTIME_UTILITIES_DIAGNOSTICS_QUEUE_SIZE)
+#define REALTIME_UTILITIES_DIAGNOSTICS_QUEUE_SIZE 256
+#endif
+
+#if !defined(REALTIME_UTILITIES_DIAGNOSTICS_MAX_VALUES)
+#define REALTIME_UTILITIES_DIAGNOSTICS_MAX_VALUES 4
+#endif
 
 namespace realtime_utilities
 {
 
+struct tasks;
+
 class DiagnosticsInterface
 {
 public:
 
   typedef std::shared_ptr<DiagnosticsInterface> Ptr;
   typedef std::shared_ptr<DiagnosticsInterface const> ConstPtr;
+  typedef std::size_t TrackerHandle;
+  typedef uint32_t    MessageId;
 
-  DiagnosticsInterface() = default;
+  // same values of diagnostic_msgs::DiagnosticStatus levels
+  enum Level { LEVEL_OK = 0, LEVEL_WARN = 1, LEVEL_ERROR = 2, LEVEL_STALE = 3 };
+
+  DiagnosticsInterface() : trackers_(std::make_shared<std::deque<realtime_utilities::TimeSpanTracker>>()), rt_queue_(new RtQueue()) {}
   virtual ~DiagnosticsInterface() = default;
   DiagnosticsInterface(const DiagnosticsInterface&) = delete;
   DiagnosticsInterface& operator=(const DiagnosticsInterface&) = delete;
@@ -53,8 +71,34 @@ public:
                           , const std::map<std::string, std::string>& key_values
                           , std::stringstream* report);
 
+  /**
+   * @brief RT-safe messages: the summary and the names of the numeric values
+   * are registered once at set-up, then the RT threads post fixed-size
+   * records (level, message id, up to REALTIME_UTILITIES_DIAGNOSTICS_MAX_VALUES
+   * values) into a lock-free queue, with no allocation nor lock. The records
+   * are formatted into DiagnosticStatus messages by diagnostics(), in the
+   * diagnostics thread. postDiagnosticsMessage returns false, and counts the
+   * message as dropped, if the queue is full.
+   */
+  MessageId registerDiagnosticsMessage(const std::string& summary, const std::vector<std::string>& value_names = {});
+  bool postDiagnosticsMessage(const Level& level, const MessageId& id, std::initializer_list<double> values = {});
+  size_t droppedDiagnosticsMessages() const { return rt_queue_->dropped.load(std::memory_order_relaxed); };
+
   virtual void addTimeTracker(const std::string& id, const double& period);
 
+  /**
+   * @brief the statistics of the pool (queue length, enqueue-to-start latency,
+   * run time, utilisation) are published by diagnosticsPerformance.
+   * The interface shares the ownership of the pool, as for the profilers.
+   */
+  virtual void addTasksPool(const std::string& id, const std::shared_ptr<const realtime_utilities::tasks>& pool);
+
+  /**
+   * @brief the per-phase durations, share of the period and slack of the
+   * profiler are published by diagnosticsPerformance.
+   */
+  virtual void addCycleProfiler(const std::string& id, const realtime_utilities::CycleProfilerPtr& profiler);
+
   virtual void diagnostics           (diagnostic_updater::DiagnosticStatusWrapper &stat, int level);
   virtual void diagnosticsInfo       (diagnostic_updater::DiagnosticStatusWrapper &stat);
   virtual void diagnosticsWarn       (diagnostic_updater::DiagnosticStatusWrapper &stat);
@@ -62,7 +106,55 @@ public:
   virtual void diagnosticsPerformance(diagnostic_updater::DiagnosticStatusWrapper &stat);
 
   realtime_utilities::TimeSpanTrackerPtr  timeSpanStrakcer(const std::string& id) { return time_span_tracker_.at(id); };
+  realtime_utilities::TimeSpanTrackerPtr  timeSpanTracker(const std::string& id) { return time_span_tracker_.at(id); };
+
+  /**
+   * @brief RT access to the trackers: resolve the id once at set-up, then
+   * use the handle in the loop (an index in the tracker storage, no string
+   * lookup nor reference counting). The storage is a deque, not a vector:
+   * TimeSpanTracker holds a mutex and cannot be moved, and the deque grows
+   * without moving the trackers already added. Adding an id again resets its
+   * tracker in place at the new period: handles stay valid for the life of
+   * the interface. addTimeTracker must not run concurrently with the loop.
+   */
+  TrackerHandle timeSpanTrackerHandle(const std::string& id) const { return tracker_handles_.at(id); };
+  realtime_utilities::TimeSpanTracker* timeSpanTracker(const TrackerHandle& handle) { return &(*trackers_)[handle]; };
 private:
+  struct RtMessage
+  {
+    Level     level;
+    MessageId id;
+    int64_t   stamp;  // [ns] CLOCK_REALTIME
+    uint32_t  n_values;
+    double    values[REALTIME_UTILITIES_DIAGNOSTICS_MAX_VALUES];
+  };
+  struct RtQueue
+  {
+    mpmc_queue<RtMessage, REALTIME_UTILITIES_DIAGNOSTICS_QUEUE_SIZE> queue;
+    std::atomic<size_t>                                              dropped{0};
+
+    // mpmc_queue is cache line aligned, C++14 new does not honour it
+    static void* operator new(std::size_t size)
+    {
+      void* p = nullptr;
+      if (posix_memalign(&p, cache_line_size, size) != 0)
+        throw std::bad_alloc();
+      return p;
+    }
+    static void operator delete(void* p)
+    {
+      free(p);
+    }
+  };
+  struct RegisteredMessage
+  {
+    std::string              summary;
+    std::vector<std::string> value_names;
+  };
+
+  // format the posted RT messages into diagnostic_, under mtx_
+  void drainRtMessages();
+
   std::string    hardware_id_;
   std::string    name_id_;
   std::string    timer_id_;
@@ -71,6 +163,12 @@ private:
   mutable diagnostic_msgs::DiagnosticArray                       diagnostic_;
   std::map<std::string, realtime_utilities::TimeSpanTrackerPtr>  time_span_tracker_;
   std::map<std::string, double >                                 period_;
+  std::map<std::string, TrackerHandle>                           tracker_handles_;
+  std::shared_ptr<std::deque<realtime_utilities::TimeSpanTracker>> trackers_;  // indexed by TrackerHandle
+  std::map<std::string, std::shared_ptr<const realtime_utilities::tasks>> tasks_pools_;
+  std::map<std::string, realtime_utilities::CycleProfilerPtr>    cycle_profilers_;
+  std::unique_ptr<RtQueue>                                       rt_queue_;
+  std::vector<RegisteredMessage>                                 rt_messages_;
 };
 
 template <typename T>
@@ -0,0 +1,184 @@
+#ifndef REALTIME_UTILITIES_HISTOGRAM_H
+#define REALTIME_UTILITIES_HISTOGRAM_H
+
+#include <atomic>
+#include <limits>
+#include <cstddef>
+#include <cstdint>
+
+namespace realtime_utilities
+{
+
+// Log-linear histogram of non-negative integer samples (typically durations
+// in ns), recorded with relaxed atomics only: no lock, no allocation, a
+// fixed 8 KB footprint. Every power of two is split in 2^sub_bits linear
+// buckets, so percentiles have a relative error below 1/2^sub_bits (~6%)
+// over the whole int64 range, while min, max and mean are exact.
+//
+// record() may be called by several threads, but it is cheapest with one
+// writer per histogram (e.g. one per worker, merged by the reader).
+class histogram
+{
+public:
+  static constexpr int         sub_bits    = 4;
+  static constexpr std::size_t sub_buckets = std::size_t(1) << sub_bits;
+  static constexpr std::size_t buckets     = (64 - sub_bits) * sub_buckets;
+
+  struct summary
+  {
+    std::size_t count;
+    int64_t     min;
+    int64_t     max;
+    double      mean;
+    int64_t     p50;
+    int64_t     p90;
+    int64_t     p99;
+    int64_t     p999;
+  };
+
+  histogram()
+  {
+    reset();
+  }
+  histogram(const histogram&) = delete;
+  histogram& operator=(const histogram&) = delete;
+
+  void record(int64_t value)
+  {
+    if (value < 0)
+      value = 0;
+    buckets_[index(value)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+
+    int64_t prev = min_.load(std::memory_order_relaxed);
+    while (value < prev && !min_.compare_exchange_weak(prev, value, std::memory_order_relaxed))
+    {
+    }
+    prev = max_.load(std::memory_order_relaxed);
+    while (value > prev && !max_.compare_exchange_weak(prev, value, std::memory_order_relaxed))
+    {
+    }
+  }
+
+  // add the samples of another histogram to this one
+  void merge(const histogram& other)
+  {
+    for (std::size_t i = 0; i < buckets; i++)
+    {
+      const uint64_t n = other.buckets_[i].load(std::memory_order_relaxed);
+      if (n)
+        buckets_[i].fetch_add(n, std::memory_order_relaxed);
+    }
+    sum_.fetch_add(other.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    count_.fetch_add(other.count_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+    const int64_t omin = other.min_.load(std::memory_order_relaxed);
+    int64_t prev = min_.load(std::memory_order_relaxed);
+    while (omin < prev && !min_.compare_exchange_weak(prev, omin, std::memory_order_relaxed))
+    {
+    }
+    const int64_t omax = other.max_.load(std::memory_order_relaxed);
+    prev = max_.load(std::memory_order_relaxed);
+    while (omax > prev && !max_.compare_exchange_weak(prev, omax, std::memory_order_relaxed))
+    {
+    }
+  }
+
+  // not atomic with respect to concurrent record(): a few samples may be lost
+  void reset()
+  {
+    for (std::size_t i = 0; i < buckets; i++)
+      buckets_[i].store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    count_.store(0, std::memory_order_relaxed);
+    min_.store(std::numeric_limits<int64_t>::max(), std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+  }
+
+  std::size_t count() const
+  {
+    return count_.load(std::memory_order_relaxed);
+  }
+  int64_t min() const
+  {
+    return count() ? min_.load(std::memory_order_relaxed) : 0;
+  }
+  int64_t max() const
+  {
+    return max_.load(std::memory_order_relaxed);
+  }
+  double mean() const
+  {
+    const std::size_t n = count();
+    return n ? double(sum_.load(std::memory_order_relaxed)) / double(n) : 0.0;
+  }
+
+  // upper bound of the bucket holding the p-th quantile (p in [0,1]),
+  // clamped to the largest recorded sample
+  int64_t percentile(double p) const
+  {
+    uint64_t total = 0;
+    for (std::size_t i = 0; i < buckets; i++)
+      total += buckets_[i].load(std::memory_order_relaxed);
+    if (total == 0)
+      return 0;
+
+    const uint64_t rank = p <= 0.0 ? 1 : p >= 1.0 ? total : uint64_t(p * double(total) + 0.5);
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets; i++)
+    {
+      seen += buckets_[i].load(std::memory_order_relaxed);
+      if (seen >= rank && seen > 0)
+      {
+        const int64_t upper = upper_bound(i);
+        const int64_t m = max();
+        return upper < m ? upper : m;
+      }
+    }
+    return max();
+  }
+
+  summary summarize() const
+  {
+    summary s;
+    s.count = count();
+    s.min   = min();
+    s.max   = max();
+    s.mean  = mean();
+    s.p50   = percentile(0.5);
+    s.p90   = percentile(0.9);
+    s.p99   = percentile(0.99);
+    s.p999  = percentile(0.999);
+    return s;
+  }
+
+  static std::size_t index(int64_t value)
+  {
+    const uint64_t v = uint64_t(value);
+    if (v < sub_buckets)
+      return std::size_t(v);
+    const int e = 63 - __builtin_clzll(v);
+    const uint64_t sub = (v >> (e - sub_bits)) & (sub_buckets - 1);
+    return std::size_t(e - sub_bits + 1) * sub_buckets + std::size_t(sub);
+  }
+  static int64_t upper_bound(std::size_t index)
+  {
+    if (index < sub_buckets)
+      return int64_t(index);
+    const int e = int(index / sub_buckets) + sub_bits - 1;
+    const uint64_t sub = index % sub_buckets;
+    return int64_t(((sub_buckets + sub + 1) << (e - sub_bits)) - 1);
+  }
+
+private:
+  std::atomic<uint64_t> buckets_[buckets];
+  std::atomic<int64_t>  sum_;
+  std::atomic<uint64_t> count_;
+  std::atomic<int64_t>  min_;
+  std::atomic<int64_t>  max_;
+};
+
+}  // namespace realtime_utilities
+
+#endif  // REALTIME_UTILITIES_HISTOGRAM_H
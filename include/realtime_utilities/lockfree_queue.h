@@ -0,0 +1,187 @@
+#ifndef REALTIME_UTILITIES_LOCKFREE_QUEUE_H
+#define REALTIME_UTILITIES_LOCKFREE_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <realtime_utilities/circular_buffer_fixed.h>
+
+namespace realtime_utilities
+{
+
+// Bounded multi-producer / multi-consumer queue (D. Vyukov).
+// Every slot carries a sequence number telling whether it is ready to be
+// written or read, so producers and consumers only contend on their own index.
+template <typename T, std::size_t N>
+class mpmc_queue
+{
+  static_assert(is_power_of_two(N), "mpmc_queue capacity must be a power of two");
+
+public:
+  mpmc_queue() : enqueue_pos_(0), dequeue_pos_(0)
+  {
+    for (std::size_t i = 0; i < N; i++)
+      cells_[i].seq.store(i, std::memory_order_relaxed);
+  }
+  mpmc_queue(const mpmc_queue&) = delete;
+  mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+  bool push(const T& item)
+  {
+    cell* c;
+    std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true)
+    {
+      c = &cells_[pos & mask];
+      const std::size_t seq = c->seq.load(std::memory_order_acquire);
+      const std::intptr_t diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+      if (diff == 0)
+      {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if (diff < 0)
+      {
+        return false;
+      }
+      else
+      {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    c->data = item;
+    c->seq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T& item)
+  {
+    cell* c;
+    std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    while (true)
+    {
+      c = &cells_[pos & mask];
+      const std::size_t seq = c->seq.load(std::memory_order_acquire);
+      const std::intptr_t diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+      if (diff == 0)
+      {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if (diff < 0)
+      {
+        return false;
+      }
+      else
+      {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    item = c->data;
+    c->seq.store(pos + mask + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  static constexpr std::size_t mask = N - 1;
+
+  struct cell
+  {
+    std::atomic<std::size_t> seq;
+    T                        data;
+  };
+
+  alignas(cache_line_size) cell cells_[N];
+  alignas(cache_line_size) std::atomic<std::size_t> enqueue_pos_;
+  alignas(cache_line_size) std::atomic<std::size_t> dequeue_pos_;
+};
+
+// Bounded work-stealing deque (Chase-Lev, with the C11 memory orders of
+// Le et al., PPoPP 2013). The owner thread pushes and pops at the bottom,
+// any other thread steals from the top. Elements are pointers.
+template <typename T, std::size_t N>
+class ws_deque
+{
+  static_assert(is_power_of_two(N), "ws_deque capacity must be a power of two");
+  static_assert(std::is_pointer<T>::value, "ws_deque elements must be pointers");
+
+public:
+  ws_deque() : top_(0), bottom_(0)
+  {
+    for (auto& b : buffer_)
+      b.store(nullptr, std::memory_order_relaxed);
+  }
+  ws_deque(const ws_deque&) = delete;
+  ws_deque& operator=(const ws_deque&) = delete;
+
+  // owner only
+  bool push(T item)
+  {
+    const int64_t b = bottom_.load(std::memory_order_relaxed);
+    const int64_t t = top_.load(std::memory_order_acquire);
+    if (b - t >= static_cast<int64_t>(N))
+      return false;
+    buffer_[b & mask].store(item, std::memory_order_relaxed);
+    bottom_.store(b + 1, std::memory_order_release);
+    return true;
+  }
+
+  // owner only, LIFO
+  T pop()
+  {
+    const int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    T item = nullptr;
+    if (t <= b)
+    {
+      item = buffer_[b & mask].load(std::memory_order_relaxed);
+      if (t == b)
+      {
+        // last element: race against the thieves
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+          item = nullptr;
+        bottom_.store(b + 1, std::memory_order_relaxed);
+      }
+    }
+    else
+    {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  // any thread, FIFO. Returns nullptr when empty or when the race is lost.
+  T steal()
+  {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b)
+      return nullptr;
+    T item = buffer_[t & mask].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+      return nullptr;
+    return item;
+  }
+
+  std::size_t size() const
+  {
+    const int64_t b = bottom_.load(std::memory_order_relaxed);
+    const int64_t t = top_.load(std::memory_order_relaxed);
+    return b > t ? static_cast<std::size_t>(b - t) : 0;
+  }
+
+private:
+  static constexpr int64_t mask = N - 1;
+
+  alignas(cache_line_size) std::atomic<int64_t> top_;
+  alignas(cache_line_size) std::atomic<int64_t> bottom_;
+  alignas(cache_line_size) std::atomic<T>       buffer_[N];
+};
+
+}  // namespace realtime_utilities
+
+#endif  // REALTIME_UTILITIES_LOCKFREE_QUEUE_H
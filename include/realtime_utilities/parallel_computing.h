@@ -2,23 +2,297 @@
 #define REALTIME_UTILITIES__PARALLEL_COMPUTING__H
 
 #include <mutex>
+#include <condition_variable>
 #include <future>
 #include <deque>
 #include <vector>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <type_traits>
+#include <string>
+#include <cstring>
+#include <stdexcept>
+#include <sched.h>
+#include <pthread.h>
+#include <realtime_utilities/realtime_utilities.h>
+#include <realtime_utilities/histogram.h>
 
 namespace realtime_utilities
 {
 
+// hint to the core that the caller is busy-waiting (pause on x86)
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+// How an idle tasks worker waits for the next job: it polls the queues for
+// the spin time (busy loop with cpu_relax()), then for the yield time
+// (sched_yield between polls), and only then sleeps on the condition
+// variable. The default sleeps at once; with workers on isolated cores a
+// spin budget of a cycle or so avoids the futex wake-up latency.
+struct wait_policy
+{
+  std::chrono::nanoseconds spin{0};
+  std::chrono::nanoseconds yield{0};
+};
+
+// Waits for a fixed number of count_down(). The waiter spins for a short
+// while before sleeping, since the counted jobs are usually short. The count
+// and a "waiter sleeping" bit share one atomic word: count_down() is a single
+// fetch_sub, and only the final one takes the mutex, when the waiter sleeps.
+// A sleeping waiter returns only once that final count_down() has notified
+// it, so the latch can be destroyed as soon as wait() returns.
+class completion_latch
+{
+public:
+  explicit completion_latch(std::size_t count) : state_(count << 1), woken_(false) {}
+  completion_latch(const completion_latch&) = delete;
+  completion_latch& operator=(const completion_latch&) = delete;
+
+  // n must not exceed the remaining count
+  void count_down(std::size_t n = 1)
+  {
+    const std::size_t old = state_.fetch_sub(n << 1, std::memory_order_acq_rel);
+    if ((old >> 1) == n && (old & sleeping))
+    {
+      std::lock_guard<std::mutex> l(mtx_);
+      woken_ = true;
+      notifier_.notify_all();
+    }
+  }
+  bool try_wait() const
+  {
+    return (state_.load(std::memory_order_acquire) >> 1) == 0;
+  }
+  void wait(std::size_t spin = 4096)
+  {
+    for (std::size_t i = 0; i < spin && !try_wait(); i++)
+    {
+      cpu_relax();
+    }
+    std::size_t s = state_.load(std::memory_order_acquire);
+    do
+    {
+      if ((s >> 1) == 0)
+        return;
+    } while (!state_.compare_exchange_weak(s, s | sleeping, std::memory_order_acq_rel, std::memory_order_acquire));
+    std::unique_lock<std::mutex> l(mtx_);
+    notifier_.wait(l, [&]{ return woken_; });
+  }
+  // re-arm a latch nobody is using any more
+  void reset(std::size_t count)
+  {
+    state_.store(count << 1, std::memory_order_relaxed);
+    woken_ = false;
+  }
+
+private:
+  enum : std::size_t { sleeping = 1 };
+
+  std::atomic<std::size_t> state_;   // count << 1 | sleeping
+  std::mutex               mtx_;
+  std::condition_variable  notifier_;
+  bool                     woken_;   // guarded by mtx_
+};
+
+#if !defined(REALTIME_UTILITIES_TASK_INLINE_SIZE)
+#define REALTIME_UTILITIES_TASK_INLINE_SIZE 64
+#endif
+
+#if !defined(REALTIME_UTILITIES_TASK_SLOTS)
+#define REALTIME_UTILITIES_TASK_SLOTS 256
+#endif
+
+// Type-erased void() callable stored in an inline buffer: it never allocates,
+// and callables larger than REALTIME_UTILITIES_TASK_INLINE_SIZE bytes are
+// rejected at compile time.
+class inline_task
+{
+public:
+  template<class F>
+  struct fits
+  {
+    typedef typename std::decay<F>::type D;
+    static constexpr bool value = sizeof(D) <= REALTIME_UTILITIES_TASK_INLINE_SIZE
+                               && alignof(D) <= alignof(std::max_align_t);
+  };
+
+  inline_task() : invoke_(nullptr), destroy_(nullptr) {}
+  inline_task(const inline_task&) = delete;
+  inline_task& operator=(const inline_task&) = delete;
+  ~inline_task()
+  {
+    reset();
+  }
+
+  template<class F>
+  void emplace(F&& f)
+  {
+    typedef typename std::decay<F>::type D;
+    static_assert(fits<F>::value, "callable too large for inline_task, increase REALTIME_UTILITIES_TASK_INLINE_SIZE");
+    reset();
+    new (&storage_) D(std::forward<F>(f));
+    invoke_  = [](void* p) { (*static_cast<D*>(p))(); };
+    destroy_ = [](void* p) { static_cast<D*>(p)->~D(); };
+  }
+  void operator()()
+  {
+    invoke_(&storage_);
+  }
+  void reset()
+  {
+    if (destroy_)
+      destroy_(&storage_);
+    invoke_  = nullptr;
+    destroy_ = nullptr;
+  }
+  bool valid() const
+  {
+    return invoke_ != nullptr;
+  }
+
+private:
+  typename std::aligned_storage<REALTIME_UTILITIES_TASK_INLINE_SIZE, alignof(std::max_align_t)>::type storage_;
+  void (*invoke_)(void*);
+  void (*destroy_)(void*);
+};
+
+// Scheduling classes of tasks::queue()/submit(). Jobs queued without a
+// priority are NORMAL and FIFO. Jobs with a priority or a deadline are
+// ordered by priority, then earliest deadline first: CRITICAL and HIGH ones,
+// and NORMAL ones with a deadline, jump ahead of the FIFO jobs; BACKGROUND
+// ones run only when nothing else is queued.
+enum task_priority { PRIORITY_CRITICAL, PRIORITY_HIGH, PRIORITY_NORMAL, PRIORITY_BACKGROUND };
+
+typedef std::chrono::steady_clock::time_point task_deadline;
+
+struct deadline_stats
+{
+  std::size_t scheduled;     // completed jobs that had a deadline
+  std::size_t started_late;  // ... started after the deadline
+  std::size_t missed;        // ... completed after the deadline
+  double      max_lateness;  // [s], worst completion time past the deadline
+};
+
+// Snapshot of the tasks instrumentation, durations in ns. Every worker
+// records, in its own histograms, the enqueue-to-start latency and run time
+// of its jobs, the idle spans between them, and the number of jobs still
+// queued when it takes one.
+struct tasks_stats
+{
+  struct worker
+  {
+    std::size_t        jobs;
+    double             busy;         // [s] total run time
+    double             idle;         // [s] total idle time
+    double             utilisation;  // busy / (busy + idle)
+    histogram::summary latency;
+    histogram::summary run;
+    histogram::summary idle_span;
+  };
+  std::vector<worker> workers;
+
+  // all the workers together
+  std::size_t        jobs;
+  std::size_t        queued;         // jobs waiting when the snapshot was taken
+  double             utilisation;
+  histogram::summary latency;
+  histogram::summary run;
+  histogram::summary idle_span;
+  histogram::summary queue_length;
+};
+
+struct tasks;
+
+// Completion handle of a job queued with tasks::submit(). Move-only; the task
+// slot goes back to the pool once both the job has run and the handle has
+// been destroyed. Handles must not outlive their pool. A job dropped by
+// cancel_pending() completes with a broken_promise future_error, as the
+// future of a dropped packaged_task would.
+class task_handle
+{
+public:
+  task_handle() : pool_(nullptr), index_(0) {}
+  task_handle(task_handle&& h) : pool_(h.pool_), index_(h.index_)
+  {
+    h.pool_ = nullptr;
+  }
+  task_handle& operator=(task_handle&& h)
+  {
+    if (this != &h)
+    {
+      release();
+      pool_ = h.pool_;
+      index_ = h.index_;
+      h.pool_ = nullptr;
+    }
+    return *this;
+  }
+  task_handle(const task_handle&) = delete;
+  task_handle& operator=(const task_handle&) = delete;
+  ~task_handle()
+  {
+    release();
+  }
+
+  // false if the job was not queued, as no task slot was free
+  bool valid() const
+  {
+    return pool_ != nullptr;
+  }
+  bool ready() const;
+  // spin for a short while, then sleep until the job is completed
+  void wait() const;
+  // wait, then rethrow the exception thrown by the job, if any
+  void get() const;
+
+private:
+  friend struct tasks;
+  task_handle(tasks* pool, std::size_t index) : pool_(pool), index_(index) {}
+  void release();
+
+  tasks*      pool_;
+  std::size_t index_;
+};
+
 struct tasks 
 {
-  
+  tasks() : free_count_(REALTIME_UTILITIES_TASK_SLOTS), ready_head_(0), ready_count_(0), timed_slots_count_(0), timed_seq_(0)
+    , queued_(0), sleeping_(0), spin_ns_(0), yield_ns_(0), live_(0), stopping_(false), slot_waiters_(0), n_stats_(0)
+    , deadline_scheduled_(0), deadline_started_late_(0), deadline_missed_(0), deadline_max_lateness_ns_(0)
+  {
+    for (std::size_t i = 0; i < REALTIME_UTILITIES_TASK_SLOTS; i++)
+    {
+      free_[i] = i;
+      slots_[i].refs.store(0, std::memory_order_relaxed);
+      slots_[i].done.store(false, std::memory_order_relaxed);
+    }
+  }
+  tasks(const tasks&) = delete;
+  tasks& operator=(const tasks&) = delete;
+
   // the mutex, condition variable and deque form a single
   // thread-safe triggered queue of tasks:
   std::mutex mtx_;
   std::condition_variable notifier_;
 
   // note that a packaged_task<void> can store a packaged_task<R>:
-  std::deque<std::packaged_task<void()>> work_;
+  struct queued_task
+  {
+    std::packaged_task<void()> task;
+    int64_t                    enqueued;  // [ns], steady clock
+  };
+  std::deque<queued_task> work_;
 
   // this holds futures representing the worker threads being done:
   std::vector<std::future<void>> finished_;
@@ -36,27 +310,227 @@ struct tasks
     auto r=p.get_future(); // get the return value before we hand off the task
     {
       std::unique_lock<std::mutex> l(mtx_);
-      work_.emplace_back(std::move(p)); // store the task<R()> as a task<void()>
+      if (stopping_)
+        return r; // after finish() the task is dropped: get() throws broken_promise
+      work_.push_back(queued_task{std::packaged_task<void()>(std::move(p)), now_ns()}); // store the task<R()> as a task<void()>
+      queued_.fetch_add(1, std::memory_order_release);
     }
-    notifier_.notify_one(); // wake a thread to work_ on the task
+    wake_one(); // wake a thread to work_ on the task
 
     return r; // return the future result of the task
   }
 
+  // queue( lambda, priority, deadline ) as above, scheduled by priority and
+  // then earliest deadline first. NORMAL jobs without a deadline are FIFO,
+  // as if queued without a priority.
+  template<class F, class R=std::result_of_t<F&()>>
+  std::future<R> queue(F&& f, task_priority priority, task_deadline deadline = task_deadline::max())
+  {
+    if (priority == PRIORITY_NORMAL && deadline == task_deadline::max())
+      return queue(std::forward<F>(f));
+
+    std::packaged_task<R()> p(std::forward<F>(f));
+    auto r=p.get_future();
+    {
+      std::unique_lock<std::mutex> l(mtx_);
+      if (stopping_)
+        return r;
+      timed_.push_back(timed_job{timed_key{priority, deadline, timed_seq_++}, std::packaged_task<void()>(std::move(p)), now_ns()});
+      std::push_heap(timed_.begin(), timed_.end(), timed_job_later());
+      queued_.fetch_add(1, std::memory_order_release);
+    }
+    wake_one();
+    return r;
+  }
+
+  // submit( lambda ) is the allocation-free version of queue(): the lambda
+  // is stored in a preallocated task slot (REALTIME_UTILITIES_TASK_SLOTS of
+  // them, REALTIME_UTILITIES_TASK_INLINE_SIZE bytes each) and completion is
+  // tracked by a task_handle instead of a future. The returned handle is not
+  // valid if every slot is in use, or once finish() has been called. Slot
+  // jobs are served before queue() ones.
+  template<class F>
+  task_handle submit(F&& f)
+  {
+    std::size_t i;
+    {
+      std::unique_lock<std::mutex> l(mtx_);
+      if (stopping_ || free_count_ == 0)
+        return task_handle();
+      i = claim_slot_locked(std::forward<F>(f));
+      ready_[(ready_head_ + ready_count_) % REALTIME_UTILITIES_TASK_SLOTS] = i;
+      ready_count_++;
+      queued_.fetch_add(1, std::memory_order_release);
+    }
+    wake_one();
+    return task_handle(this, i);
+  }
+  // submit( lambda, priority, deadline ): allocation-free too, the slot jobs
+  // have their own fixed-size heap. NORMAL jobs without a deadline are FIFO.
+  template<class F>
+  task_handle submit(F&& f, task_priority priority, task_deadline deadline = task_deadline::max())
+  {
+    if (priority == PRIORITY_NORMAL && deadline == task_deadline::max())
+      return submit(std::forward<F>(f));
+
+    std::size_t i;
+    {
+      std::unique_lock<std::mutex> l(mtx_);
+      if (stopping_ || free_count_ == 0)
+        return task_handle();
+      i = claim_slot_locked(std::forward<F>(f));
+      slots_[i].key = timed_key{priority, deadline, timed_seq_++};
+      timed_slots_[timed_slots_count_++] = i;
+      std::push_heap(timed_slots_, timed_slots_ + timed_slots_count_, timed_slot_later{slots_});
+      queued_.fetch_add(1, std::memory_order_release);
+    }
+    wake_one();
+    return task_handle(this, i);
+  }
+
+  // statistics of the jobs queued with a deadline
+  deadline_stats deadlineStatistics() const
+  {
+    deadline_stats ret;
+    ret.scheduled    = deadline_scheduled_.load(std::memory_order_relaxed);
+    ret.started_late = deadline_started_late_.load(std::memory_order_relaxed);
+    ret.missed       = deadline_missed_.load(std::memory_order_relaxed);
+    ret.max_lateness = 1e-9 * deadline_max_lateness_ns_.load(std::memory_order_relaxed);
+    return ret;
+  }
+
+  // execute( lambda ) enqueues a job whose result nobody waits for, without
+  // a future: small lambdas take a task slot and do not allocate, the others
+  // (or all of them when no slot is free) are wrapped in a packaged_task,
+  // which allocates its shared state. Returns false, and drops the job, once
+  // finish() has been called.
+  template<class F>
+  bool execute(F&& f)
+  {
+    return execute(std::forward<F>(f), std::integral_constant<bool, inline_task::fits<F>::value>());
+  }
+
+  // number of running worker threads: the stopped ones are not counted
+  std::size_t size() const
+  {
+    return live_.load(std::memory_order_acquire);
+  }
+
+  // true if the calling thread is a worker of this pool, i.e. a job that
+  // blocks waiting for other jobs of the pool can starve them
+  bool in_worker() const
+  {
+    return current_pool() == this;
+  }
+
+  // number of jobs waiting for a worker
+  std::size_t queued() const
+  {
+    return queued_.load(std::memory_order_relaxed);
+  }
+
+  // how idle workers wait for jobs, can be changed while running
+  void set_wait_policy(const wait_policy& policy)
+  {
+    spin_ns_.store(policy.spin.count(), std::memory_order_relaxed);
+    yield_ns_.store(policy.yield.count(), std::memory_order_relaxed);
+  }
+  wait_policy get_wait_policy() const
+  {
+    wait_policy ret;
+    ret.spin  = std::chrono::nanoseconds(spin_ns_.load(std::memory_order_relaxed));
+    ret.yield = std::chrono::nanoseconds(yield_ns_.load(std::memory_order_relaxed));
+    return ret;
+  }
+
+  // snapshot of the instrumentation, e.g. for DiagnosticsInterface
+  tasks_stats statistics() const
+  {
+    tasks_stats ret;
+    std::unique_ptr<histogram> latency(new histogram()), run(new histogram()), idle(new histogram()), queue_length(new histogram());
+    double busy = 0, idle_time = 0;
+    const std::size_t n = n_stats_.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < n; i++)
+    {
+      const worker_stats& w = *stats_[i];
+      tasks_stats::worker s;
+      s.latency     = w.latency.summarize();
+      s.run         = w.run.summarize();
+      s.idle_span   = w.idle.summarize();
+      s.jobs        = s.run.count;
+      s.busy        = 1e-9 * w.busy_ns.load(std::memory_order_relaxed);
+      s.idle        = 1e-9 * w.idle_ns.load(std::memory_order_relaxed);
+      s.utilisation = s.busy + s.idle > 0 ? s.busy / (s.busy + s.idle) : 0.0;
+      ret.workers.push_back(s);
+
+      latency->merge(w.latency);
+      run->merge(w.run);
+      idle->merge(w.idle);
+      queue_length->merge(w.queue_length);
+      busy      += s.busy;
+      idle_time += s.idle;
+    }
+    ret.queued       = queued();
+    ret.latency      = latency->summarize();
+    ret.run          = run->summarize();
+    ret.idle_span    = idle->summarize();
+    ret.queue_length = queue_length->summarize();
+    ret.jobs         = ret.run.count;
+    ret.utilisation  = busy + idle_time > 0 ? busy / (busy + idle_time) : 0.0;
+    return ret;
+  }
+  void reset_statistics()
+  {
+    const std::size_t n = n_stats_.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < n; i++)
+    {
+      stats_[i]->latency.reset();
+      stats_[i]->run.reset();
+      stats_[i]->idle.reset();
+      stats_[i]->queue_length.reset();
+      stats_[i]->busy_ns.store(0, std::memory_order_relaxed);
+      stats_[i]->idle_ns.store(0, std::memory_order_relaxed);
+    }
+  }
+
   // start N threads in the thread pool.
   void start(std::size_t N=1)
   {
     for (std::size_t i = 0; i < N; ++i)
     {
       // each thread is a std::async running this->thread_task():
+      const std::size_t index = add_worker_stats();
+      live_.fetch_add(1, std::memory_order_acq_rel);
       finished_.push_back(
         std::async(
           std::launch::async,
-          [this]{ thread_task(); }
+          [this, index]{ thread_task(index); }
         )
       );
     }
   }
+  // start one thread per spec, with create_rt_thread(): affinity and stack
+  // size as pthread attributes, then setprio() and a pre-faulted stack.
+  void start(const std::vector<worker_spec>& specs)
+  {
+    for (const worker_spec& spec : specs)
+    {
+      const std::size_t index = add_worker_stats();
+      std::shared_ptr<std::promise<void>> done = std::make_shared<std::promise<void>>();
+      std::future<void> finished = done->get_future();
+
+      pthread_t thread;
+      live_.fetch_add(1, std::memory_order_acq_rel);
+      int err = create_rt_thread(&thread, spec, [this, index, done]{ thread_task(index); done->set_value(); }, "tasks");
+      if (err != 0)
+      {
+        live_.fetch_sub(1, std::memory_order_acq_rel);
+        throw std::runtime_error("tasks: error in creating the worker thread: " + std::string(strerror(err)));
+      }
+      threads_.push_back(thread);
+      finished_.push_back(std::move(finished));
+    }
+  }
   // abort() cancels all non-started tasks, and tells every working thread
   // stop running, and waits for them to finish up.
   void abort() 
@@ -69,15 +543,32 @@ struct tasks
   {
     std::unique_lock<std::mutex> l(mtx_);
     work_.clear();
+    timed_.clear();
+    for (std::size_t k = 0; k < timed_slots_count_; k++)
+    {
+      cancel_slot_locked(timed_slots_[k]);
+    }
+    timed_slots_count_ = 0;
+    while (ready_count_ > 0)
+    {
+      std::size_t i = ready_[ready_head_];
+      ready_head_ = (ready_head_ + 1) % REALTIME_UTILITIES_TASK_SLOTS;
+      ready_count_--;
+      cancel_slot_locked(i);
+    }
+    queued_.store(0, std::memory_order_relaxed);
+    slot_done_.notify_all();
   }
   // finish enques a "stop the thread" message for every thread, then waits for them:
   void finish() 
   {
     {
       std::unique_lock<std::mutex> locker(mtx_);
+      stopping_ = true;
       for(auto&& unused: finished_)
       {
-        work_.push_back({});
+        work_.push_back(queued_task{std::packaged_task<void()>(), now_ns()});
+        queued_.fetch_add(1, std::memory_order_release);
       }
     }
     notifier_.notify_all();
@@ -86,33 +577,426 @@ struct tasks
   ~tasks() 
   {
     finish();
+    // the workers use the slots and the queues declared after finished_:
+    // wait for them here, not in the destruction of finished_
+    for (auto& done : finished_)
+    {
+      done.wait();
+    }
+    for (pthread_t& thread : threads_)
+    {
+      pthread_join(thread, nullptr);
+    }
   }
 private:
+  friend class task_handle;
+
+  // order of the jobs queued with a priority or a deadline
+  struct timed_key
+  {
+    task_priority priority;
+    task_deadline deadline;
+    uint64_t      seq;
+  };
+  struct timed_key_later
+  {
+    bool operator()(const timed_key& a, const timed_key& b) const
+    {
+      if (a.priority != b.priority)
+        return a.priority > b.priority;
+      if (a.deadline != b.deadline)
+        return a.deadline > b.deadline;
+      return a.seq > b.seq;
+    }
+  };
+  // does a prioritized job go before the FIFO queues?
+  static bool urgent(const timed_key& key)
+  {
+    return key.priority < PRIORITY_NORMAL || (key.priority == PRIORITY_NORMAL && key.deadline != task_deadline::max());
+  }
+
+  struct task_slot
+  {
+    inline_task        fn;
+    std::exception_ptr error;
+    std::atomic<int>   refs;
+    std::atomic<bool>  done;
+    int64_t            enqueued;
+    timed_key          key;  // submit() with a priority
+  };
+
+  // fixed pool of task slots: free list and FIFO of the ready ones, both
+  // guarded by mtx_
+  task_slot   slots_[REALTIME_UTILITIES_TASK_SLOTS];
+  std::size_t free_[REALTIME_UTILITIES_TASK_SLOTS];
+  std::size_t free_count_;
+  std::size_t ready_[REALTIME_UTILITIES_TASK_SLOTS];
+  std::size_t ready_head_;
+  std::size_t ready_count_;
+
+  // jobs queued with a priority or a deadline: two heaps (guarded by mtx_)
+  // whose tops are the jobs with the highest priority and earliest deadline,
+  // one for queue() and a fixed-size one of slot indexes for submit()
+  struct timed_job
+  {
+    timed_key                  key;
+    std::packaged_task<void()> task;
+    int64_t                    enqueued;
+  };
+  struct timed_job_later
+  {
+    bool operator()(const timed_job& a, const timed_job& b) const
+    {
+      return timed_key_later()(a.key, b.key);
+    }
+  };
+  struct timed_slot_later
+  {
+    const task_slot* slots;
+    bool operator()(std::size_t a, std::size_t b) const
+    {
+      return timed_key_later()(slots[a].key, slots[b].key);
+    }
+  };
+  std::vector<timed_job> timed_;
+  std::size_t            timed_slots_[REALTIME_UTILITIES_TASK_SLOTS];
+  std::size_t            timed_slots_count_;
+  uint64_t               timed_seq_;
+
+  // jobs in any queue (modified under mtx_, polled without it by the
+  // spinning workers) and workers sleeping on notifier_: producers skip the
+  // notify when nobody sleeps
+  std::atomic<std::size_t> queued_;
+  std::atomic<std::size_t> sleeping_;
+  std::atomic<int64_t>     spin_ns_;
+  std::atomic<int64_t>     yield_ns_;
+
+  // workers that have not processed their stop message yet, and finish()
+  // called (guarded by mtx_)
+  std::atomic<std::size_t> live_;
+  bool                     stopping_;
+
+  // task_handle::wait() sleeps on slot_done_ (with mtx_); the workers notify
+  // it only when somebody is waiting
+  std::condition_variable  slot_done_;
+  std::atomic<std::size_t> slot_waiters_;
+
+  // per-worker instrumentation, written only by its worker
+  struct worker_stats
+  {
+    histogram            latency;
+    histogram            run;
+    histogram            idle;
+    histogram            queue_length;
+    std::atomic<int64_t> busy_ns{0};
+    std::atomic<int64_t> idle_ns{0};
+  };
+  std::unique_ptr<worker_stats> stats_[REALTIME_UTILITIES_MAX_WORKERS];
+  std::atomic<std::size_t>      n_stats_;
+
+  std::size_t add_worker_stats()
+  {
+    const std::size_t i = n_stats_.load(std::memory_order_relaxed);
+    if (i >= REALTIME_UTILITIES_MAX_WORKERS)
+    {
+      throw std::runtime_error("tasks: too many workers, increase REALTIME_UTILITIES_MAX_WORKERS");
+    }
+    stats_[i].reset(new worker_stats());
+    n_stats_.store(i + 1, std::memory_order_release);
+    return i;
+  }
+
+  static int64_t now_ns()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  void wake_one()
+  {
+    if (sleeping_.load(std::memory_order_seq_cst) > 0)
+      notifier_.notify_one();
+  }
+
+  // spin, then yield, until a job is queued or the wait policy budget is over
+  void poll_for_work() const
+  {
+    const int64_t spin_ns  = spin_ns_.load(std::memory_order_relaxed);
+    const int64_t yield_ns = yield_ns_.load(std::memory_order_relaxed);
+    if (spin_ns <= 0 && yield_ns <= 0)
+      return;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    auto elapsed = [&t0]
+    {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+    };
+    while (queued_.load(std::memory_order_acquire) == 0 && elapsed() < spin_ns)
+    {
+      for (int i = 0; i < 64 && queued_.load(std::memory_order_relaxed) == 0; i++)
+        cpu_relax();
+    }
+    while (queued_.load(std::memory_order_acquire) == 0 && elapsed() < spin_ns + yield_ns)
+    {
+      std::this_thread::yield();
+    }
+  }
+
+  std::atomic<std::size_t> deadline_scheduled_;
+  std::atomic<std::size_t> deadline_started_late_;
+  std::atomic<std::size_t> deadline_missed_;
+  std::atomic<int64_t>     deadline_max_lateness_ns_;
+
+  template<class F>
+  std::size_t claim_slot_locked(F&& f)
+  {
+    const std::size_t i = free_[--free_count_];
+    slots_[i].fn.emplace(std::forward<F>(f));
+    slots_[i].error = nullptr;
+    slots_[i].done.store(false, std::memory_order_relaxed);
+    slots_[i].refs.store(2, std::memory_order_relaxed);  // the handle and the worker
+    slots_[i].enqueued = now_ns();
+    return i;
+  }
+
+  bool has_work_locked() const
+  {
+    return !work_.empty() || ready_count_ > 0 || !timed_.empty() || timed_slots_count_ > 0;
+  }
+  // the first prioritized job, nullptr if there is none; *from_slots tells
+  // which heap it is on top of
+  const timed_key* timed_top_locked(bool* from_slots) const
+  {
+    const timed_key* top = timed_.empty() ? nullptr : &timed_.front().key;
+    *from_slots = false;
+    if (timed_slots_count_ > 0)
+    {
+      const timed_key& k = slots_[timed_slots_[0]].key;
+      if (!top || timed_key_later()(*top, k))
+      {
+        top = &k;
+        *from_slots = true;
+      }
+    }
+    return top;
+  }
+
+  void account_deadline(const task_deadline& deadline, const task_deadline& start)
+  {
+    if (deadline == task_deadline::max())
+      return;
+    const task_deadline end = std::chrono::steady_clock::now();
+    deadline_scheduled_.fetch_add(1, std::memory_order_relaxed);
+    if (start > deadline)
+      deadline_started_late_.fetch_add(1, std::memory_order_relaxed);
+    if (end > deadline)
+    {
+      deadline_missed_.fetch_add(1, std::memory_order_relaxed);
+      const int64_t lateness = std::chrono::duration_cast<std::chrono::nanoseconds>(end - deadline).count();
+      int64_t prev = deadline_max_lateness_ns_.load(std::memory_order_relaxed);
+      while (lateness > prev && !deadline_max_lateness_ns_.compare_exchange_weak(prev, lateness, std::memory_order_relaxed))
+      {
+      }
+    }
+  }
+
+  template<class F>
+  bool execute(F&& f, std::true_type)
+  {
+    if (submit(std::forward<F>(f)).valid())
+      return true;
+    return execute(std::forward<F>(f), std::false_type());
+  }
+  template<class F>
+  bool execute(F&& f, std::false_type)
+  {
+    {
+      std::unique_lock<std::mutex> l(mtx_);
+      if (stopping_)
+        return false;
+      work_.push_back(queued_task{std::packaged_task<void()>(std::forward<F>(f)), now_ns()});
+      queued_.fetch_add(1, std::memory_order_release);
+    }
+    wake_one();
+    return true;
+  }
+
+  void release_slot(std::size_t i)
+  {
+    if (slots_[i].refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      std::unique_lock<std::mutex> l(mtx_);
+      free_[free_count_++] = i;
+    }
+  }
+  void release_slot_locked(std::size_t i)
+  {
+    if (slots_[i].refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      free_[free_count_++] = i;
+  }
+
+  void run_slot(std::size_t i)
+  {
+    try
+    {
+      slots_[i].fn();
+    }
+    catch (...)
+    {
+      slots_[i].error = std::current_exception();
+    }
+    slots_[i].fn.reset();
+    slots_[i].done.store(true, std::memory_order_seq_cst);
+    if (slot_waiters_.load(std::memory_order_seq_cst) > 0)
+    {
+      std::unique_lock<std::mutex> l(mtx_);
+      slot_done_.notify_all();
+    }
+    release_slot(i);
+  }
+  void cancel_slot_locked(std::size_t i)
+  {
+    slots_[i].fn.reset();
+    slots_[i].error = std::make_exception_ptr(std::future_error(std::future_errc::broken_promise));
+    slots_[i].done.store(true, std::memory_order_seq_cst);
+    release_slot_locked(i);
+  }
+  void wait_slot(std::size_t i)
+  {
+    std::unique_lock<std::mutex> l(mtx_);
+    slot_waiters_.fetch_add(1, std::memory_order_seq_cst);
+    slot_done_.wait(l, [&]{ return slots_[i].done.load(std::memory_order_seq_cst); });
+    slot_waiters_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  // the workers created by start(specs):
+  std::vector<pthread_t> threads_;
+
   // the work_ that a worker thread does:
-  void thread_task() 
+  static const tasks*& current_pool()
   {
+    static thread_local const tasks* pool = nullptr;
+    return pool;
+  }
+
+  void thread_task(std::size_t index)
+  {
+    current_pool() = this;
+    worker_stats& stats = *stats_[index];
+    int64_t idle_since = now_ns();
     while(true)
     {
-      // pop a task off the queue:
+      // pop a task off the queues, by priority: urgent prioritized jobs, slot
+      // jobs, queue() jobs, background jobs, and finally the stop messages
       std::packaged_task<void()> f;
+      std::size_t slot = REALTIME_UTILITIES_TASK_SLOTS;
+      task_deadline deadline = task_deadline::max();
+      int64_t enqueued = 0;
       {
+        if (queued_.load(std::memory_order_acquire) == 0)
+        {
+          poll_for_work();
+        }
         // usual thread-safe queue code:
         std::unique_lock<std::mutex> locker(mtx_);
-        if(work_.empty())
+        if(!has_work_locked())
         {
-          notifier_.wait(locker,[&]{return !work_.empty();});
+          sleeping_.fetch_add(1, std::memory_order_seq_cst);
+          notifier_.wait(locker,[&]{return has_work_locked();});
+          sleeping_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        stats.queue_length.record(int64_t(queued_.fetch_sub(1, std::memory_order_relaxed)) - 1);
+        bool from_slots;
+        const timed_key* top = timed_top_locked(&from_slots);
+        if (top && (urgent(*top) || (ready_count_ == 0 && (work_.empty() || !work_.front().task.valid()))))
+        {
+          deadline = top->deadline;
+          if (from_slots)
+          {
+            std::pop_heap(timed_slots_, timed_slots_ + timed_slots_count_, timed_slot_later{slots_});
+            slot = timed_slots_[--timed_slots_count_];
+            enqueued = slots_[slot].enqueued;
+          }
+          else
+          {
+            std::pop_heap(timed_.begin(), timed_.end(), timed_job_later());
+            timed_job& job = timed_.back();
+            f = std::move(job.task);
+            enqueued = job.enqueued;
+            timed_.pop_back();
+          }
+        }
+        else if (ready_count_ > 0)
+        {
+          slot = ready_[ready_head_];
+          ready_head_ = (ready_head_ + 1) % REALTIME_UTILITIES_TASK_SLOTS;
+          ready_count_--;
+          enqueued = slots_[slot].enqueued;
+        }
+        else
+        {
+          f = std::move(work_.front().task);
+          enqueued = work_.front().enqueued;
+          work_.pop_front();
         }
-        f = std::move(work_.front());
-        work_.pop_front();
       }
       // if the task is invalid, it means we are asked to abort:
-      if (!f.valid()) return;
-      // otherwise, run the task:
-      f();
+      if (slot == REALTIME_UTILITIES_TASK_SLOTS && !f.valid())
+      {
+        live_.fetch_sub(1, std::memory_order_acq_rel);
+        return;
+      }
+
+      const int64_t started = now_ns();
+      stats.latency.record(started - enqueued);
+      stats.idle.record(started - idle_since);
+      stats.idle_ns.fetch_add(started - idle_since, std::memory_order_relaxed);
+      const task_deadline start = deadline != task_deadline::max() ? std::chrono::steady_clock::now() : task_deadline();
+      if (slot != REALTIME_UTILITIES_TASK_SLOTS)
+      {
+        run_slot(slot);
+      }
+      else
+      {
+        f();
+      }
+      account_deadline(deadline, start);
+
+      idle_since = now_ns();
+      stats.run.record(idle_since - started);
+      stats.busy_ns.fetch_add(idle_since - started, std::memory_order_relaxed);
     }
   }
 };
 
+inline bool task_handle::ready() const
+{
+  return pool_ && pool_->slots_[index_].done.load(std::memory_order_acquire);
+}
+
+inline void task_handle::wait() const
+{
+  for (int i = 0; i < 1024 && pool_ && !ready(); i++)
+  {
+    cpu_relax();
+  }
+  if (pool_ && !ready())
+    pool_->wait_slot(index_);
+}
+
+inline void task_handle::get() const
+{
+  wait();
+  if (pool_ && pool_->slots_[index_].error)
+    std::rethrow_exception(pool_->slots_[index_].error);
+}
+
+inline void task_handle::release()
+{
+  if (pool_)
+    pool_->release_slot(index_);
+  pool_ = nullptr;
+}
+
 }  // namespace realtime_utilities
 
 #endif   // REALTIME_UTILITIES__PARALLEL_COMPUTING__H
\ No newline at end of file
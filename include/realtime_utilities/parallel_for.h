@@ -0,0 +1,213 @@
+#ifndef REALTIME_UTILITIES__PARALLEL_FOR__H
+#define REALTIME_UTILITIES__PARALLEL_FOR__H
+
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <exception>
+#include <realtime_utilities/parallel_computing.h>
+#include <realtime_utilities/lockfree_queue.h>
+
+#if !defined(REALTIME_UTILITIES_PARALLEL_FOR_STATES)
+#define REALTIME_UTILITIES_PARALLEL_FOR_STATES 64
+#endif
+
+namespace realtime_utilities
+{
+
+namespace internal
+{
+
+// State of one loop, shared by the caller and the helpers it queued. The
+// caller waits for the chunks, not for the helpers: a helper that starts
+// once all the chunks are taken returns at once, possibly after the caller
+// left the loop. So the state is reference counted and recycled through a
+// fixed pool (heap fallback when all of them are in use), and the helpers
+// touch the caller stack only through the chunks they take.
+struct loop_state
+{
+  loop_state() : refs(0), next(0), chunks(0), done(0), body(nullptr), run_chunk(nullptr) {}
+
+  // run chunks until none is left to take
+  void run()
+  {
+    std::size_t c;
+    while ((c = next.fetch_add(1, std::memory_order_relaxed)) < chunks)
+    {
+      try
+      {
+        run_chunk(body, c);
+      }
+      catch (...)
+      {
+        {
+          std::lock_guard<std::mutex> l(error_mtx);
+          if (!error)
+            error = std::current_exception();
+        }
+        // the chunks nobody took yet are dropped
+        const std::size_t taken = next.exchange(chunks, std::memory_order_relaxed);
+        if (taken < chunks)
+          done.count_down(chunks - taken);
+      }
+      done.count_down();
+    }
+  }
+
+  std::atomic<std::size_t> refs;
+  std::atomic<std::size_t> next;
+  std::size_t              chunks;
+  completion_latch         done;  // counts the chunks
+  void*                    body;
+  void                   (*run_chunk)(void* body, std::size_t chunk);
+  std::mutex               error_mtx;
+  std::exception_ptr       error;
+};
+
+struct loop_state_pool
+{
+  loop_state_pool()
+  {
+    for (auto& s : states)
+      free_list.push(&s);
+  }
+
+  loop_state* acquire(std::size_t refs)
+  {
+    loop_state* s = nullptr;
+    if (!free_list.pop(s))
+      s = new loop_state();
+    s->refs.store(refs, std::memory_order_relaxed);
+    return s;
+  }
+  void release(loop_state* s)
+  {
+    if (s->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+      return;
+    s->error = nullptr;
+    if (s >= states && s < states + REALTIME_UTILITIES_PARALLEL_FOR_STATES)
+      free_list.push(s);
+    else
+      delete s;
+  }
+
+  loop_state                                                           states[REALTIME_UTILITIES_PARALLEL_FOR_STATES];
+  mpmc_queue<loop_state*, REALTIME_UTILITIES_PARALLEL_FOR_STATES>     free_list;
+};
+
+inline loop_state_pool& loop_states()
+{
+  static loop_state_pool pool;
+  return pool;
+}
+
+// Chunks are handed out by an atomic counter, so that fast participants take
+// more of them. Only one job per helper is queued in the pool, whatever the
+// number of chunks, and a latch counting the chunks tells the caller that
+// the loop is done. The helpers are queued with tasks::execute(), i.e. in
+// task slots when they are free, and the loop state comes from a pool: no
+// future is created, and no allocation. When the pool does not take them
+// (finish() already called) the caller runs the chunks itself.
+template<typename Index, typename Body>
+void parallel_chunks(tasks& pool, Index begin, Index end, Index grain, Body&& body, bool caller_participates)
+{
+  if (end <= begin)
+    return;
+
+  const std::size_t workers = pool.size();
+  const std::size_t n = static_cast<std::size_t>(end - begin);
+  if (grain <= 0)
+  {
+    // automatic chunking: a few chunks per participant for load balancing
+    grain = static_cast<Index>(std::max<std::size_t>(1, n / (4 * (workers + 1))));
+  }
+  const std::size_t chunks = (n + grain - 1) / grain;
+
+  if (workers == 0 || (chunks == 1 && caller_participates))
+  {
+    body(begin, end);
+    return;
+  }
+  // a job of the pool must not sleep waiting for helpers queued behind it
+  if (pool.in_worker())
+    caller_participates = true;
+
+  auto chunk = [&](std::size_t c)
+  {
+    const Index b = begin + static_cast<Index>(c) * grain;
+    body(b, std::min(end, static_cast<Index>(b + grain)));
+  };
+  typedef decltype(chunk) chunk_type;
+
+  const std::size_t helpers = std::min(workers, caller_participates ? chunks - 1 : chunks);
+  loop_state_pool& states = loop_states();
+  loop_state* state = states.acquire(helpers + 1);
+  state->next.store(0, std::memory_order_relaxed);
+  state->chunks = chunks;
+  state->done.reset(chunks);
+  state->body = &chunk;
+  state->run_chunk = [](void* b, std::size_t c) { (*static_cast<chunk_type*>(b))(c); };
+
+  std::size_t queued = 0;
+  for (std::size_t i = 0; i < helpers; i++)
+  {
+    if (pool.execute([state]{ state->run(); loop_states().release(state); }))
+      queued++;
+    else
+      states.release(state);
+  }
+  if (caller_participates || queued == 0)
+  {
+    state->run();
+  }
+  state->done.wait();
+
+  std::exception_ptr error = state->error;
+  states.release(state);
+  if (error)
+    std::rethrow_exception(error);
+}
+
+}  // namespace internal
+
+// parallel_for( pool, begin, end, grain, f ) calls f(i) for every i in
+// [begin, end), split in chunks of grain indexes (grain <= 0: automatic).
+// With caller_participates the calling thread runs chunks too, instead of
+// just sleeping until the workers are done; without workers, or after
+// finish(), it runs all of them. Called from a job of the same pool (nested
+// loops) the caller always participates, so that it never waits for helpers
+// that cannot start. The first exception thrown by f is rethrown to the
+// caller, the chunks not started yet are skipped.
+template<typename Index, typename F>
+void parallel_for(tasks& pool, Index begin, Index end, Index grain, F&& f, bool caller_participates = true)
+{
+  internal::parallel_chunks(pool, begin, end, grain, [&](Index b, Index e)
+  {
+    for (Index i = b; i < e; ++i)
+      f(i);
+  }, caller_participates);
+}
+
+// parallel_reduce( pool, begin, end, grain, identity, f, combine ) returns
+// the combination of f(i) over [begin, end). Every chunk is accumulated in a
+// local partial result, then merged into the total: combine must be
+// associative and commutative, as the merge order is not defined.
+template<typename Index, typename T, typename F, typename Combine>
+T parallel_reduce(tasks& pool, Index begin, Index end, Index grain, const T& identity, F&& f, Combine&& combine, bool caller_participates = true)
+{
+  T          result = identity;
+  std::mutex result_mtx;
+  internal::parallel_chunks(pool, begin, end, grain, [&](Index b, Index e)
+  {
+    T partial = identity;
+    for (Index i = b; i < e; ++i)
+      partial = combine(partial, f(i));
+    std::lock_guard<std::mutex> l(result_mtx);
+    result = combine(result, partial);
+  }, caller_participates);
+  return result;
+}
+
+}  // namespace realtime_utilities
+
+#endif   // REALTIME_UTILITIES__PARALLEL_FOR__H
@@ -0,0 +1,108 @@
+#ifndef REALTIME_UTILITIES__PERIODIC_SCHEDULER__H
+#define REALTIME_UTILITIES__PERIODIC_SCHEDULER__H
+
+#include <map>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+#include <pthread.h>
+#include <realtime_utilities/realtime_utilities.h>
+#include <realtime_utilities/time_span_tracker.h>
+
+namespace realtime_utilities
+{
+
+/**
+ * @class PeriodicScheduler
+ *
+ * Runs periodic callbacks with the timer_periodic_init / timer_inc_period /
+ * timer_wait_rest_of_period loop, so that the components do not have to
+ * write it by hand.
+ *
+ * Every task is assigned to a thread by name: tasks sharing the thread name
+ * are multiplexed on the same thread (the earliest activation runs first),
+ * a task without thread name gets its own thread. Threads are configured
+ * with a worker_spec (affinity, policy, priority, pre-faulted stack) and
+ * created by create_rt_thread().
+ *
+ * All the activations are aligned to a common start time, plus the phase
+ * offset of the task. The execution time of every activation is measured by
+ * a TimeSpanTracker.
+ */
+class PeriodicScheduler
+{
+public:
+  typedef std::shared_ptr<PeriodicScheduler> Ptr;
+
+  // what to do when an activation ends after the next one was due:
+  // SKIP the missed activations, CATCH_UP running them back to back,
+  // or skip them and WARN on stdout at the next reportOverruns()
+  enum OverrunPolicy { SKIP, CATCH_UP, WARN };
+
+  struct TaskConfig
+  {
+    std::string   name;
+    long          period_ns = 0;
+    long          phase_ns  = 0;
+    OverrunPolicy overrun   = SKIP;
+    std::string   thread;
+  };
+
+  PeriodicScheduler() : running_(false) {}
+  virtual ~PeriodicScheduler();
+  PeriodicScheduler(const PeriodicScheduler&) = delete;
+  PeriodicScheduler& operator=(const PeriodicScheduler&) = delete;
+
+  // configuration, before start()
+  bool addTask(const TaskConfig& config, std::function<void()> callback);
+  void configureThread(const std::string& thread, const worker_spec& spec);
+
+  bool start();
+  void stop();
+  bool isRunning() const { return running_; }
+
+  realtime_utilities::TimeSpanTrackerPtr tracker(const std::string& task) const;
+  size_t overruns(const std::string& task) const;
+
+  // prints the activations skipped by the WARN tasks since the previous
+  // report, and returns their number. The RT threads only count the
+  // overruns: call it from a non-RT thread, e.g. the diagnostics one
+  // (stop() calls it too).
+  size_t reportOverruns();
+
+private:
+  struct Task
+  {
+    TaskConfig                             config;
+    std::function<void()>                  callback;
+    period_info                            pinfo;
+    realtime_utilities::TimeSpanTrackerPtr tracker;
+    std::atomic<size_t>                    overruns;
+    std::atomic<size_t>                    reported;  // overruns already printed
+  };
+  struct Thread
+  {
+    std::string        name;
+    worker_spec        spec;
+    std::vector<Task*> tasks;
+    pthread_t          handle;
+    bool               started = false;
+    PeriodicScheduler* scheduler = nullptr;
+  };
+
+  void loop(Thread* thread);
+  Task* task(const std::string& name) const;
+
+  std::vector<std::unique_ptr<Task>>    tasks_;
+  std::map<std::string, worker_spec>    specs_;
+  std::vector<std::unique_ptr<Thread>>  threads_;
+  std::atomic<bool>                     running_;
+};
+
+typedef PeriodicScheduler::Ptr PeriodicSchedulerPtr;
+
+}  // namespace realtime_utilities
+
+#endif  // REALTIME_UTILITIES__PERIODIC_SCHEDULER__H
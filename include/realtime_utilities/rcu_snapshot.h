@@ -0,0 +1,150 @@
+#ifndef REALTIME_UTILITIES_RCU_SNAPSHOT_H
+#define REALTIME_UTILITIES_RCU_SNAPSHOT_H
+
+#include <mutex>
+#include <deque>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <realtime_utilities/circular_buffer_fixed.h>
+
+namespace realtime_utilities
+{
+
+// Read-copy-update holder for read-mostly data (gains, limits, ...).
+//
+// Readers get a wait-free pointer to an immutable snapshot. Writers publish a
+// whole new copy; the replaced one is queued and freed by reclaim() once every
+// registered reader has announced a quiescent state, i.e. it does not hold any
+// pointer obtained before the publication (quiescent-state based reclamation).
+//
+// Typical RT loop:
+//   const Gains* g = gains.read();   // beginning of the cycle
+//   ...                              // use *g
+//   gains.quiescent(reader);         // end of the cycle, g is not used anymore
+//
+// Readers never lock nor allocate: publish() and reclaim() run in non-RT
+// threads and are serialized by an internal mutex.
+template <class T, std::size_t MaxReaders = 8>
+class rcu_snapshot
+{
+public:
+  typedef int reader_id;
+
+  explicit rcu_snapshot(std::unique_ptr<T> initial) : current_(initial.release()), epoch_(1)
+  {
+    for (auto& r : readers_)
+    {
+      r.epoch.store(0, std::memory_order_relaxed);
+      r.active.store(false, std::memory_order_relaxed);
+    }
+  }
+  explicit rcu_snapshot(const T& initial) : rcu_snapshot(std::unique_ptr<T>(new T(initial))) {}
+  rcu_snapshot(const rcu_snapshot&) = delete;
+  rcu_snapshot& operator=(const rcu_snapshot&) = delete;
+
+  ~rcu_snapshot()
+  {
+    for (auto& r : retired_)
+      delete r.first;
+    delete current_.load(std::memory_order_acquire);
+  }
+
+  // Must be called by the reader thread before its first read().
+  // Returns -1 when all the MaxReaders slots are taken.
+  reader_id register_reader()
+  {
+    for (std::size_t i = 0; i < MaxReaders; i++)
+    {
+      bool expected = false;
+      if (!readers_[i].active.compare_exchange_strong(expected, true, std::memory_order_seq_cst))
+        continue;
+      readers_[i].epoch.store(epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+      return static_cast<reader_id>(i);
+    }
+    return -1;
+  }
+  void unregister_reader(reader_id id)
+  {
+    readers_[id].active.store(false, std::memory_order_seq_cst);
+  }
+
+  // reader side, wait-free
+  const T* read() const
+  {
+    return current_.load(std::memory_order_seq_cst);
+  }
+  void quiescent(reader_id id)
+  {
+    readers_[id].epoch.store(epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+  }
+
+  // writer side
+  void publish(std::unique_ptr<T> snapshot)
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    publish_locked(snapshot.release());
+  }
+  // copy the current snapshot, let f modify the copy, publish it
+  template <class F>
+  void update(F&& f)
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::unique_ptr<T> copy(new T(*current_.load(std::memory_order_seq_cst)));
+    f(*copy);
+    publish_locked(copy.release());
+  }
+
+  // Free the replaced snapshots no reader can still hold. Returns how many
+  // are still waiting for a grace period.
+  std::size_t reclaim()
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return reclaim_locked();
+  }
+
+private:
+  void publish_locked(const T* snapshot)
+  {
+    const T* old = current_.exchange(snapshot, std::memory_order_seq_cst);
+    const uint64_t epoch = epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+    retired_.emplace_back(old, epoch);
+    reclaim_locked();
+  }
+
+  std::size_t reclaim_locked()
+  {
+    uint64_t safe = epoch_.load(std::memory_order_seq_cst);
+    for (const auto& r : readers_)
+    {
+      if (r.active.load(std::memory_order_seq_cst))
+        safe = std::min(safe, r.epoch.load(std::memory_order_seq_cst));
+    }
+    while (!retired_.empty() && retired_.front().second <= safe)
+    {
+      delete retired_.front().first;
+      retired_.pop_front();
+    }
+    return retired_.size();
+  }
+
+  struct alignas(cache_line_size) reader
+  {
+    std::atomic<uint64_t> epoch;
+    std::atomic<bool>     active;
+  };
+
+  std::atomic<const T*> current_;
+  alignas(cache_line_size) std::atomic<uint64_t> epoch_;
+  reader readers_[MaxReaders];
+
+  std::mutex                                 mtx_;
+  std::deque<std::pair<const T*, uint64_t>>  retired_;
+};
+
+}  // namespace realtime_utilities
+
+#endif  // REALTIME_UTILITIES_RCU_SNAPSHOT_H
@@ -22,6 +22,9 @@
 #include <mutex>
 #include <string>
 #include <vector>
+#include <atomic>
+#include <functional>
+#include <realtime_utilities/histogram.h>
 
 namespace realtime_utilities
 {
@@ -39,6 +42,29 @@ bool show_new_pagefault_count(const char* logtext, const char* allowed_maj, cons
 
 bool prove_thread_stack_use_is_safe(size_t stacksize);
 
+// upper bound of the workers of a tasks or work_stealing_tasks pool
+#if !defined(REALTIME_UTILITIES_MAX_WORKERS)
+#define REALTIME_UTILITIES_MAX_WORKERS 64
+#endif
+
+// placement and scheduling of a worker thread
+struct worker_spec
+{
+  std::vector<int> cpus;            // allowed cores, empty means no affinity
+  int              sched = SCHED_OTHER;
+  int              prio  = 0;
+  std::size_t      stack_size = 0;  // if not 0, stack pre-faulted at start-up
+};
+
+// Creates a thread that runs fn with the placement and scheduling of spec:
+// affinity and stack size are set as pthread attributes, then the thread
+// sets its own policy with setprio() and pre-faults its stack (like
+// prove_thread_stack_use_is_safe(), but silently, since several workers may
+// start at once) before calling fn. An attribute or a
+// policy that cannot be applied is reported on stdout, prefixed by who, and
+// the thread keeps the default. Returns the error of pthread_create().
+int create_rt_thread(pthread_t* thread, const worker_spec& spec, std::function<void()> fn, const std::string& who);
+
 bool error(int at);
 
 bool configure_malloc_behavior(void);
@@ -55,6 +81,27 @@ void   timer_periodic_init(period_info *pinfo, long period_ns);
 
 int    timer_wait_rest_of_period(struct timespec *ts);
 
+// Wake-up latency of timer_wait_rest_of_period(), as cyclictest measures it:
+// the waits given a recorder read the clock before and after the sleep, and
+// record how late [ns] the thread runs after the requested time. Waits whose
+// requested time was already past are counted as overruns instead. The
+// recorder is written by the waiting thread only, and can be read by other
+// threads; construct it before the loop.
+struct wakeup_stats
+{
+  histogram::summary latency;
+  std::size_t        overruns;
+};
+struct wakeup_recorder
+{
+  histogram           latency;
+  std::atomic<size_t> overruns{0};
+
+  wakeup_stats statistics() const;
+  void         reset();
+};
+int    timer_wait_rest_of_period(struct timespec *ts, wakeup_recorder* recorder);
+
 void   timer_add(struct timespec *ts, int64_t addtime);
 
 
@@ -67,6 +114,57 @@ int64_t timer_to_ns(const struct timespec *timeA_p);
 
 std::vector<std::string> get_ifaces();
 
+struct thread_usage
+{
+  int64_t minor_faults;
+  int64_t major_faults;
+  int64_t voluntary_switches;    // the thread blocked
+  int64_t involuntary_switches;  // the thread was preempted
+  int64_t cpu_time_ns;
+};
+
+// Per-cycle resource usage of a thread, to tell preemption (involuntary
+// context switches, CPU time well below the cycle time) from compute
+// overruns. sample() must be called by the measured thread once per cycle:
+// it reads getrusage(RUSAGE_THREAD) and CLOCK_THREAD_CPUTIME_ID and stores
+// the deltas since the previous call (the first call only sets the
+// reference). The getters and reset() can be called by any thread: reset()
+// only raises a flag, and the next sample() clears the statistics and takes
+// a new reference, so no delta spans the reset.
+class thread_usage_sampler
+{
+public:
+  thread_usage_sampler();
+  thread_usage_sampler(const thread_usage_sampler&) = delete;
+  thread_usage_sampler& operator=(const thread_usage_sampler&) = delete;
+
+  bool sample();
+  void reset();
+
+  thread_usage last() const;   // the last cycle
+  thread_usage total() const;  // sum of the cycles since reset()
+  thread_usage max() const;    // worst cycle, field by field
+  size_t cycles() const;
+  size_t preempted_cycles() const;  // cycles with involuntary context switches
+  size_t faulted_cycles() const;    // cycles with page faults
+
+private:
+  enum { MINOR_FAULTS, MAJOR_FAULTS, VOLUNTARY_SWITCHES, INVOLUNTARY_SWITCHES, CPU_TIME, FIELDS };
+
+  static thread_usage to_usage(const std::atomic<int64_t>* v);
+  void clear();
+
+  int64_t              prev_[FIELDS];
+  bool                 has_prev_;
+  std::atomic<int64_t> last_[FIELDS];
+  std::atomic<int64_t> total_[FIELDS];
+  std::atomic<int64_t> max_[FIELDS];
+  std::atomic<size_t>  cycles_;
+  std::atomic<size_t>  preempted_;
+  std::atomic<size_t>  faulted_;
+  std::atomic<bool>    reset_requested_;
+};
+
 
 inline
 bool rt_init_thread(size_t stack_size, int prio, int sched, period_info*  pinfo, long  period_ns)
@@ -0,0 +1,113 @@
+#ifndef REALTIME_UTILITIES_SPSC_RING_H
+#define REALTIME_UTILITIES_SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <realtime_utilities/circular_buffer_fixed.h>
+
+namespace realtime_utilities
+{
+
+// Lock-free single-producer / single-consumer ring.
+//
+// The object is a plain block of memory (inline slots and two address-free
+// atomic counters), so it can be placed in a shared memory segment and used
+// by two different processes. Push on a full ring fails instead of
+// overwriting: the consumer may be reading the oldest slot.
+template <typename T, std::size_t N>
+class spsc_ring
+{
+  static_assert(is_power_of_two(N), "spsc_ring capacity must be a power of two");
+  static_assert(std::is_trivially_copyable<T>::value, "spsc_ring elements must be trivially copyable");
+  static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "spsc_ring requires lock-free 64 bit atomics");
+
+public:
+  spsc_ring() : head_(0), tail_(0) {}
+  spsc_ring(const spsc_ring&) = delete;
+  spsc_ring& operator=(const spsc_ring&) = delete;
+
+  // producer side
+  bool push(const T& item)
+  {
+    const uint64_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) >= N)
+      return false;
+    data_[tail & mask] = item;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer side
+  bool pop(T& item)
+  {
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+      return false;
+    item = data_[head & mask];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer side, in place access: the oldest and the newest published
+  // item, nullptr when the ring is empty. The slots stay valid until the
+  // consumer pops them.
+  const T* front() const
+  {
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+      return nullptr;
+    return &data_[head & mask];
+  }
+  const T* back() const
+  {
+    const uint64_t tail = tail_.load(std::memory_order_acquire);
+    if (head_.load(std::memory_order_relaxed) == tail)
+      return nullptr;
+    return &data_[(tail - 1) & mask];
+  }
+  bool pop()
+  {
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+      return false;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer side: drop everything that has been published so far
+  void clear()
+  {
+    head_.store(tail_.load(std::memory_order_acquire), std::memory_order_release);
+  }
+
+  std::size_t size() const
+  {
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    return tail_.load(std::memory_order_acquire) - head;
+  }
+  bool empty() const
+  {
+    return size() == 0;
+  }
+  bool full() const
+  {
+    return size() >= N;
+  }
+  constexpr std::size_t capacity() const
+  {
+    return N;
+  }
+
+private:
+  static constexpr uint64_t mask = N - 1;
+
+  alignas(cache_line_size) std::atomic<uint64_t> head_;
+  alignas(cache_line_size) std::atomic<uint64_t> tail_;
+  alignas(cache_line_size) T data_[N];
+};
+
+}  // namespace realtime_utilities
+
+#endif  // REALTIME_UTILITIES_SPSC_RING_H
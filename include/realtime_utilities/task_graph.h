@@ -0,0 +1,312 @@
+#ifndef REALTIME_UTILITIES__TASK_GRAPH__H
+#define REALTIME_UTILITIES__TASK_GRAPH__H
+
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <exception>
+#include <stdexcept>
+#include <functional>
+#include <realtime_utilities/parallel_computing.h>
+
+namespace realtime_utilities
+{
+
+// Static DAG of jobs run on a tasks pool, e.g. a control cycle:
+//
+//   task_graph g;
+//   auto read  = g.add("read",   [&]{ ... });
+//   auto est   = g.add("estim",  [&]{ ... });
+//   auto kin   = g.add("kin",    [&]{ ... });
+//   auto dyn   = g.add("dyn",    [&]{ ... });
+//   auto ctrl  = g.add("ctrl",   [&]{ ... });
+//   g.precede(read, est); g.precede(est, kin); g.precede(est, dyn);
+//   g.precede(kin, ctrl); g.precede(dyn, ctrl);
+//   ...
+//   g.run(pool);   // every cycle
+//
+// The graph is built once. Every run resets the per-node dependency
+// counters; a node that completes decrements the counters of its successors,
+// runs the first one that becomes ready itself and puts the others in the
+// ready list of the graph, queueing a helper job in the pool through
+// tasks::execute() (task slots, no allocation) for each of them. Helpers and
+// the caller of run() take nodes from the ready list: the caller never just
+// waits, so the graph completes also when the pool has no worker, is
+// saturated or is finished. Workers never wait on each other. Each node
+// measures its execution time.
+//
+// A helper that finds the ready list empty returns at once; the graph waits
+// at destruction for the helpers still queued in the pool.
+class task_graph
+{
+public:
+  typedef std::size_t node_id;
+
+  struct node_timing
+  {
+    std::string name;
+    double      last;  // [s]
+    double      mean;  // [s]
+    double      max;   // [s]
+    std::size_t runs;
+  };
+
+  task_graph() : prepared_(false), pool_(nullptr), remaining_(0), ready_count_(0), helpers_(0) {}
+  task_graph(const task_graph&) = delete;
+  task_graph& operator=(const task_graph&) = delete;
+  ~task_graph()
+  {
+    std::unique_lock<std::mutex> l(ready_mtx_);
+    ready_cv_.wait(l, [&]{ return helpers_ == 0; });
+  }
+
+  node_id add(const std::string& name, std::function<void()> f)
+  {
+    nodes_.emplace_back(new node(name, std::move(f)));
+    prepared_ = false;
+    return nodes_.size() - 1;
+  }
+
+  // after starts only when before is completed
+  void precede(node_id before, node_id after)
+  {
+    nodes_.at(before)->successors.push_back(after);
+    nodes_.at(after)->dependencies++;
+    prepared_ = false;
+  }
+
+  // run the whole graph once and return when every node is completed. The
+  // first exception thrown by a node is rethrown here.
+  void run(tasks& pool)
+  {
+    if (!prepared_)
+      prepare();
+    if (nodes_.empty())
+      return;
+
+    pool_ = &pool;
+    error_ = nullptr;
+    remaining_.store(nodes_.size(), std::memory_order_relaxed);
+    for (auto& n : nodes_)
+      n->pending.store(n->dependencies, std::memory_order_relaxed);
+
+    // the caller runs the first root, the other ones go to the ready list
+    for (std::size_t i = 1; i < roots_.size(); i++)
+      make_ready(roots_[i]);
+    run_from(roots_.front());
+
+    // then it helps with the ready nodes until the last one is done
+    while (true)
+    {
+      node_id id;
+      {
+        std::unique_lock<std::mutex> l(ready_mtx_);
+        ready_cv_.wait(l, [&]{ return ready_count_ > 0 || remaining_.load(std::memory_order_acquire) == 0; });
+        if (ready_count_ == 0)
+          break;
+        id = ready_[--ready_count_];
+      }
+      run_from(id);
+    }
+
+    if (error_)
+      std::rethrow_exception(error_);
+  }
+
+  std::vector<node_timing> timings() const
+  {
+    std::vector<node_timing> ret;
+    for (const auto& n : nodes_)
+    {
+      node_timing t;
+      t.name = n->name;
+      t.runs = n->runs.load(std::memory_order_relaxed);
+      t.last = 1e-9 * n->last_ns.load(std::memory_order_relaxed);
+      t.max  = 1e-9 * n->max_ns.load(std::memory_order_relaxed);
+      t.mean = t.runs > 0 ? 1e-9 * double(n->sum_ns.load(std::memory_order_relaxed)) / double(t.runs) : 0.0;
+      ret.push_back(t);
+    }
+    return ret;
+  }
+
+  std::size_t size() const
+  {
+    return nodes_.size();
+  }
+
+private:
+  struct node
+  {
+    node(const std::string& n, std::function<void()>&& f)
+      : name(n), job(std::move(f)), dependencies(0), pending(0), runs(0), last_ns(0), sum_ns(0), max_ns(0) {}
+
+    const std::string     name;
+    std::function<void()> job;
+    std::vector<node_id>  successors;
+    int                   dependencies;
+    std::atomic<int>      pending;
+
+    std::atomic<std::size_t> runs;
+    std::atomic<int64_t>     last_ns;
+    std::atomic<int64_t>     sum_ns;
+    std::atomic<int64_t>     max_ns;
+  };
+
+  // compute the roots and check that the graph has no cycle (Kahn)
+  void prepare()
+  {
+    roots_.clear();
+    std::vector<int> in(nodes_.size());
+    std::vector<node_id> order;
+    for (node_id i = 0; i < nodes_.size(); i++)
+    {
+      in[i] = nodes_[i]->dependencies;
+      if (in[i] == 0)
+      {
+        roots_.push_back(i);
+        order.push_back(i);
+      }
+    }
+    for (std::size_t k = 0; k < order.size(); k++)
+    {
+      for (node_id s : nodes_[order[k]]->successors)
+      {
+        if (--in[s] == 0)
+          order.push_back(s);
+      }
+    }
+    if (order.size() != nodes_.size())
+      throw std::logic_error("task_graph: the graph has a cycle");
+    ready_.resize(nodes_.size());
+    prepared_ = true;
+  }
+
+  // counts the helper jobs alive in the pool, queued or running; the
+  // moved-from copies do not count
+  class helper_token
+  {
+  public:
+    explicit helper_token(task_graph* g) : g_(g)
+    {
+      std::lock_guard<std::mutex> l(g_->ready_mtx_);
+      g_->helpers_++;
+    }
+    helper_token(helper_token&& t) : g_(t.g_)
+    {
+      t.g_ = nullptr;
+    }
+    helper_token(const helper_token&) = delete;
+    helper_token& operator=(const helper_token&) = delete;
+    ~helper_token()
+    {
+      if (!g_)
+        return;
+      std::lock_guard<std::mutex> l(g_->ready_mtx_);
+      if (--g_->helpers_ == 0)
+        g_->ready_cv_.notify_all();
+    }
+
+  private:
+    task_graph* g_;
+  };
+
+  void make_ready(node_id id)
+  {
+    {
+      std::lock_guard<std::mutex> l(ready_mtx_);
+      ready_[ready_count_++] = id;
+      ready_cv_.notify_all();
+    }
+    if (pool_->size() > 0)
+      pool_->execute([this, token = helper_token(this)]{ help(); });
+  }
+
+  // run the ready nodes, if any is left
+  void help()
+  {
+    while (true)
+    {
+      node_id id;
+      {
+        std::lock_guard<std::mutex> l(ready_mtx_);
+        if (ready_count_ == 0)
+          return;
+        id = ready_[--ready_count_];
+      }
+      run_from(id);
+    }
+  }
+
+  void run_from(node_id id)
+  {
+    while (true)
+    {
+      node& n = *nodes_[id];
+      const auto t0 = std::chrono::steady_clock::now();
+      try
+      {
+        n.job();
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> l(error_mtx_);
+        if (!error_)
+          error_ = std::current_exception();
+      }
+      const int64_t dt = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+      n.last_ns.store(dt, std::memory_order_relaxed);
+      n.sum_ns.fetch_add(dt, std::memory_order_relaxed);
+      if (dt > n.max_ns.load(std::memory_order_relaxed))
+        n.max_ns.store(dt, std::memory_order_relaxed);
+      n.runs.fetch_add(1, std::memory_order_relaxed);
+
+      // release the successors: keep the first ready one for this thread
+      node_id next = nodes_.size();
+      for (node_id s : n.successors)
+      {
+        if (nodes_[s]->pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+          continue;
+        if (next == nodes_.size())
+          next = s;
+        else
+          make_ready(s);
+      }
+
+      if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      {
+        // wake the caller of run()
+        std::lock_guard<std::mutex> l(ready_mtx_);
+        ready_cv_.notify_all();
+        return;
+      }
+      if (next == nodes_.size())
+        return;
+      id = next;
+    }
+  }
+
+  std::vector<std::unique_ptr<node>> nodes_;
+  std::vector<node_id>               roots_;
+  bool                               prepared_;
+
+  // state of the current run
+  tasks*                   pool_;
+  std::atomic<std::size_t> remaining_;
+  std::mutex               error_mtx_;
+  std::exception_ptr       error_;
+
+  // nodes ready to run and helper jobs alive, guarded by ready_mtx_
+  std::mutex               ready_mtx_;
+  std::condition_variable  ready_cv_;
+  std::vector<node_id>     ready_;
+  std::size_t              ready_count_;
+  std::size_t              helpers_;
+};
+
+}  // namespace realtime_utilities
+
+#endif   // REALTIME_UTILITIES__TASK_GRAPH__H
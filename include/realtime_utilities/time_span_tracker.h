@@ -2,43 +2,103 @@
 #define REALTIME_UTILITIES_TIME_SPAN_TRACKER_H
 
 #include <mutex>
+#include <atomic>
+#include <cmath>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <cstdlib>
+#include <functional>
 #include <boost/thread.hpp>
 #include <boost/circular_buffer.hpp>
 #include <boost/thread/condition.hpp>
 #include <realtime_utilities/circular_buffer.h>
+#include <realtime_utilities/circular_buffer_fixed.h>
+#include <realtime_utilities/tsc_clock.h>
+#include <realtime_utilities/spsc_ring.h>
+
+#if !defined(REALTIME_UTILITIES_MISSED_CYCLES_LOG_SIZE)
+#define REALTIME_UTILITIES_MISSED_CYCLES_LOG_SIZE 64
+#endif
 
 namespace realtime_utilities
 {
 
+// a time span over the miss threshold of a TimeSpanTracker
+struct MissedCycleEvent
+{
+  int64_t  stamp;   // [ns] steady_clock (CLOCK_MONOTONIC), end of the span
+  double   span;    // [s]
+  size_t   cycle;   // index of the cycle, see getTotalCycles()
+  uint32_t tag;     // user tag set with setTag() when the cycle was missed
+};
+
 struct TimeSpanTracker
 {
   typedef std::shared_ptr< TimeSpanTracker > Ptr;
   typedef std::shared_ptr< TimeSpanTracker const > ConstPtr;
+  typedef std::function<void(const MissedCycleEvent&)> MissedCycleCallback;
 
-  const double                                   nominal_time_span_;
+  double                                         nominal_time_span_;
   size_t                                         cycles_;
   size_t                                         missed_cycles_;
   enum { NONE, TIME_SPAN, TICK_TOCK }            mode_;
 
   mutable std::mutex                             mtx_;
   realtime_utilities::circ_buffer<double>        buffer_;
-  std::chrono::high_resolution_clock::time_point last_tick_;
-  bool time_span()
+  std::chrono::steady_clock::time_point          last_tick_;
+
+  // the last REALTIME_UTILITIES_MISSED_CYCLES_LOG_SIZE missed cycles, filled
+  // by the measuring thread and emptied by one reader with popMissedCycle()
+  struct MissedCycleLog
   {
-    std::lock_guard<std::mutex> lock(mtx_);
-    if (mode_ == TICK_TOCK)
-      return false;
+    spsc_ring<MissedCycleEvent, REALTIME_UTILITIES_MISSED_CYCLES_LOG_SIZE> ring;
+    std::atomic<size_t>                                                     dropped{0};
 
-    mode_ = TIME_SPAN;
-    std::chrono::high_resolution_clock::time_point t = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> ts = std::chrono::duration_cast< std::chrono::duration<double> >(t - last_tick_);
-    buffer_.push_back(ts.count());
-    if (ts.count() > 1.2 * nominal_time_span_)
+    // spsc_ring is cache line aligned, C++14 new does not honour it
+    static void* operator new(std::size_t size)
     {
-      missed_cycles_++;
+      void* p = nullptr;
+      if (posix_memalign(&p, cache_line_size, size) != 0)
+        throw std::bad_alloc();
+      return p;
     }
-    cycles_++;
-    last_tick_ = t;
+    static void operator delete(void* p)
+    {
+      free(p);
+    }
+  };
+  double                                         miss_threshold_;
+  uint32_t                                       tag_;
+  std::unique_ptr<MissedCycleLog>                missed_log_;
+  std::shared_ptr<const MissedCycleCallback>     missed_callback_;
+
+  // running statistics over all the cycles, O(1) memory: Welford mean and
+  // variance, and exponentially weighted moving average
+  double                                         running_mean_;
+  double                                         running_m2_;
+  double                                         ewma_;
+  double                                         ewma_alpha_;
+
+  bool time_span()
+  {
+    MissedCycleEvent event;
+    bool missed;
+    std::shared_ptr<const MissedCycleCallback> callback;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (mode_ == TICK_TOCK)
+        return false;
+
+      mode_ = TIME_SPAN;
+      std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+      missed = add(t, event);
+      last_tick_ = t;
+      if (missed)
+        callback = missed_callback_;
+    }
+    if (callback)
+      (*callback)(event);
     return true;
   }
 
@@ -50,29 +110,102 @@ struct TimeSpanTracker
 
     mode_ = TICK_TOCK;
 
-    last_tick_ = std::chrono::high_resolution_clock::now();
+    last_tick_ = std::chrono::steady_clock::now();
     return true;
   }
 
   bool tock()
+  {
+    MissedCycleEvent event;
+    bool missed;
+    std::shared_ptr<const MissedCycleCallback> callback;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+
+      if (mode_ == TIME_SPAN)
+        return false;
+
+      mode_ = TICK_TOCK;
+
+      std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+      missed = add(t, event);
+      last_tick_ = t;
+      if (missed)
+        callback = missed_callback_;
+    }
+    if (callback)
+      (*callback)(event);
+    return true;
+  }
+
+  // a span is missed if longer than threshold [s], 1.2 * nominal_time_span
+  // by default
+  void setMissThreshold(const double& threshold)
   {
     std::lock_guard<std::mutex> lock(mtx_);
+    miss_threshold_ = threshold;
+  }
+  double getMissThreshold() const
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return miss_threshold_;
+  }
 
-    if (mode_ == TIME_SPAN)
-      return false;
+  // tag recorded with the next missed cycles (e.g. the state of the loop)
+  void setTag(const uint32_t& tag)
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    tag_ = tag;
+  }
 
-    mode_ = TICK_TOCK;
+  // called by the measuring thread at every missed cycle, out of the lock:
+  // it must be RT-safe. The measuring thread takes a reference to the
+  // callback under the lock, so it can be replaced at any time; the copy of
+  // the std::function is made here, not in the measuring thread.
+  void setMissedCycleCallback(const MissedCycleCallback& callback)
+  {
+    std::shared_ptr<const MissedCycleCallback> p = callback ? std::make_shared<const MissedCycleCallback>(callback) : nullptr;
+    std::lock_guard<std::mutex> lock(mtx_);
+    missed_callback_ = std::move(p);
+  }
+
+  // oldest missed cycle not read yet; a single reader thread
+  bool popMissedCycle(MissedCycleEvent& event)
+  {
+    return missed_log_->ring.pop(event);
+  }
+  // missed cycles not logged because the log was full
+  size_t getDroppedMissedCycles() const
+  {
+    return missed_log_->dropped.load(std::memory_order_relaxed);
+  }
 
-    std::chrono::high_resolution_clock::time_point t = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> ts = std::chrono::duration_cast< std::chrono::duration<double> >(t - last_tick_);
-    buffer_.push_back(ts.count());
-    if (ts.count() > 1.2 * nominal_time_span_)
+  // the span from last_tick_ to t, whose end stamps the missed cycle event
+  bool add(const std::chrono::steady_clock::time_point& t, MissedCycleEvent& event)
+  {
+    const double span = std::chrono::duration_cast< std::chrono::duration<double> >(t - last_tick_).count();
+    buffer_.push_back(span);
+
+    const double delta = span - running_mean_;
+    running_mean_ += delta / double(cycles_ + 1);
+    running_m2_   += delta * (span - running_mean_);
+    ewma_ = cycles_ == 0 ? span : ewma_ + ewma_alpha_ * (span - ewma_);
+
+    const bool missed = span > miss_threshold_;
+    if (missed)
     {
       missed_cycles_++;
+      event.stamp = std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+      event.span  = span;
+      event.cycle = cycles_;
+      event.tag   = tag_;
+      if (!missed_log_->ring.push(event))
+      {
+        missed_log_->dropped.fetch_add(1, std::memory_order_relaxed);
+      }
     }
     cycles_++;
-    last_tick_ = t;
-    return true;
+    return missed;
   }
 
   double   getMean()        const
@@ -101,6 +234,57 @@ struct TimeSpanTracker
     return cycles_;
   }
 
+  // mean, variance and standard deviation of all the cycles since start
+  double   getRunningMean() const
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return running_mean_;
+  }
+  double   getVariance() const
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return cycles_ > 1 ? running_m2_ / double(cycles_ - 1) : 0.0;
+  }
+  double   getStdDev() const
+  {
+    return std::sqrt(getVariance());
+  }
+  // exponentially weighted moving average, ewma += alpha * (span - ewma)
+  double   getEwma() const
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return ewma_;
+  }
+  // alpha in (0,1], about 2/(N+1) for an horizon of N cycles
+  void     setEwmaAlpha(const double& alpha)
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    ewma_alpha_ = alpha;
+  }
+
+  // back to the state of a tracker just constructed with these arguments,
+  // at the same address; not concurrently with the measuring thread
+  void reset(const int windows_dim, const double nominal_time_span)
+  {
+    std::unique_ptr<MissedCycleLog> log(new MissedCycleLog());
+    std::lock_guard<std::mutex> lock(mtx_);
+    nominal_time_span_ = nominal_time_span;
+    cycles_            = 0;
+    missed_cycles_     = 0;
+    mode_              = NONE;
+    buffer_.clear();
+    buffer_.set_capacity(windows_dim);
+    last_tick_         = std::chrono::steady_clock::time_point();
+    miss_threshold_    = 1.2 * nominal_time_span;
+    tag_               = 0;
+    missed_log_        = std::move(log);
+    missed_callback_   = nullptr;
+    running_mean_      = 0;
+    running_m2_        = 0;
+    ewma_              = 0;
+    ewma_alpha_        = 0.01;
+  }
+
   TimeSpanTracker() = delete;
   virtual ~TimeSpanTracker() = default;
   TimeSpanTracker(const TimeSpanTracker&) = delete;
@@ -109,12 +293,191 @@ struct TimeSpanTracker
   TimeSpanTracker& operator=(TimeSpanTracker&&) = delete;
 
   TimeSpanTracker(const int windows_dim, const double nominal_time_span)
-    : nominal_time_span_(nominal_time_span), cycles_(0),missed_cycles_(0), mode_(NONE), buffer_(windows_dim) {}
+    : nominal_time_span_(nominal_time_span), cycles_(0),missed_cycles_(0), mode_(NONE), buffer_(windows_dim)
+    , miss_threshold_(1.2 * nominal_time_span), tag_(0), missed_log_(new MissedCycleLog())
+    , running_mean_(0), running_m2_(0), ewma_(0), ewma_alpha_(0.01) {}
 };
 
 typedef TimeSpanTracker::Ptr TimeSpanTrackerPtr;
 typedef TimeSpanTracker::ConstPtr TimeSpanTrackerConstPtr;
 
+/**
+ * Same measurements as TimeSpanTracker, for a single writer thread (the RT
+ * loop) and any number of reader threads, without locks.
+ *
+ * The writer accumulates count/sum/min/max of the current window of
+ * windows_dim samples in private variables, and publishes them through a
+ * seqlock when the window is complete (and at every sample before the first
+ * window is complete): recording costs a clock read and a few plain stores.
+ * Readers get the statistics of the last complete window, retrying if the
+ * writer published in the meantime.
+ *
+ * Clock is a tick source of tsc_clock.h: the tracker works on raw ticks and
+ * converts them in seconds only in getStatistics(). With tsc_clock a
+ * tick()/tock() pair costs two rdtscp.
+ */
+template<class Clock = steady_tick_clock>
+class LockFreeTimeSpanTrackerT
+{
+public:
+  typedef Clock clock;
+  typedef std::shared_ptr< LockFreeTimeSpanTrackerT > Ptr;
+  typedef std::shared_ptr< LockFreeTimeSpanTrackerT const > ConstPtr;
+
+  struct Statistics
+  {
+    double mean;  // [s]
+    double min;   // [s]
+    double max;   // [s]
+    size_t samples;
+    size_t cycles;
+    size_t missed_cycles;
+  };
+
+  LockFreeTimeSpanTrackerT() = delete;
+  virtual ~LockFreeTimeSpanTrackerT() = default;
+  LockFreeTimeSpanTrackerT(const LockFreeTimeSpanTrackerT&) = delete;
+  LockFreeTimeSpanTrackerT& operator=(const LockFreeTimeSpanTrackerT&) = delete;
+
+  LockFreeTimeSpanTrackerT(const int windows_dim, const double nominal_time_span)
+    : nominal_time_span_(nominal_time_span), window_(windows_dim > 0 ? windows_dim : 1)
+    , miss_threshold_(int64_t(1.2 * nominal_time_span * Clock::ticks_per_second())), mode_(NONE), window_complete_(false)
+    , n_(0), sum_(0), min_(0), max_(0), seq_(0), pub_n_(0), pub_sum_(0), pub_min_(0), pub_max_(0)
+    , cycles_(0), missed_cycles_(0)
+  {
+  }
+
+  // writer side, same semantic of TimeSpanTracker
+  bool time_span()
+  {
+    if (mode_ == TICK_TOCK)
+      return false;
+    const int64_t t = Clock::ticks();
+    if (mode_ == TIME_SPAN)
+      add(t - last_tick_);
+    mode_ = TIME_SPAN;
+    last_tick_ = t;
+    return true;
+  }
+  bool tick()
+  {
+    if (mode_ == TIME_SPAN)
+      return false;
+    mode_ = TICK_TOCK;
+    last_tick_ = Clock::ticks();
+    return true;
+  }
+  bool tock()
+  {
+    if (mode_ == TIME_SPAN)
+      return false;
+    mode_ = TICK_TOCK;
+    const int64_t t = Clock::ticks();
+    add(t - last_tick_);
+    last_tick_ = t;
+    return true;
+  }
+
+  // reader side
+  Statistics getStatistics() const
+  {
+    Statistics ret;
+    int64_t n, sum, mn, mx;
+    uint64_t s0, s1;
+    do
+    {
+      s0 = seq_.load(std::memory_order_acquire);
+      n   = pub_n_.load(std::memory_order_relaxed);
+      sum = pub_sum_.load(std::memory_order_relaxed);
+      mn  = pub_min_.load(std::memory_order_relaxed);
+      mx  = pub_max_.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      s1 = seq_.load(std::memory_order_relaxed);
+    } while ((s0 & 1) || s0 != s1);
+
+    ret.samples       = size_t(n);
+    ret.mean          = n > 0 ? Clock::to_seconds(sum) / double(n) : 0.0;
+    ret.min           = Clock::to_seconds(mn);
+    ret.max           = Clock::to_seconds(mx);
+    ret.cycles        = cycles_.load(std::memory_order_relaxed);
+    ret.missed_cycles = missed_cycles_.load(std::memory_order_relaxed);
+    return ret;
+  }
+  double getMean() const { return getStatistics().mean; }
+  double getMax()  const { return getStatistics().max; }
+  double getMin()  const { return getStatistics().min; }
+  size_t getMissedCycles() const { return missed_cycles_.load(std::memory_order_relaxed); }
+  size_t getTotalCycles()  const { return cycles_.load(std::memory_order_relaxed); }
+
+  const double nominal_time_span_;
+
+private:
+  void add(const int64_t ticks)
+  {
+    if (n_ == 0 || ticks < min_) min_ = ticks;
+    if (n_ == 0 || ticks > max_) max_ = ticks;
+    sum_ += ticks;
+    n_++;
+
+    cycles_.store(cycles_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (ticks > miss_threshold_)
+      missed_cycles_.store(missed_cycles_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    const bool complete = n_ >= window_;
+    if (complete || !window_complete_)
+    {
+      publish();
+    }
+    if (complete)
+    {
+      window_complete_ = true;
+      n_ = 0;
+      sum_ = 0;
+    }
+  }
+
+  void publish()
+  {
+    const uint64_t s = seq_.load(std::memory_order_relaxed);
+    seq_.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    pub_n_.store(n_, std::memory_order_relaxed);
+    pub_sum_.store(sum_, std::memory_order_relaxed);
+    pub_min_.store(min_, std::memory_order_relaxed);
+    pub_max_.store(max_, std::memory_order_relaxed);
+    seq_.store(s + 2, std::memory_order_release);
+  }
+
+  // writer private state
+  const int64_t                       window_;
+  const int64_t                       miss_threshold_;
+  enum { NONE, TIME_SPAN, TICK_TOCK } mode_;
+  int64_t                             last_tick_;
+  bool                                window_complete_;
+  int64_t                             n_;
+  int64_t                             sum_;
+  int64_t                             min_;
+  int64_t                             max_;
+
+  // published state, on its own cache line
+  char                                pad_[cache_line_size];
+  std::atomic<uint64_t>               seq_;
+  std::atomic<int64_t>                pub_n_;
+  std::atomic<int64_t>                pub_sum_;
+  std::atomic<int64_t>                pub_min_;
+  std::atomic<int64_t>                pub_max_;
+  std::atomic<size_t>                 cycles_;
+  std::atomic<size_t>                 missed_cycles_;
+};
+
+typedef LockFreeTimeSpanTrackerT<> LockFreeTimeSpanTracker;
+typedef LockFreeTimeSpanTrackerT<tsc_clock> TscTimeSpanTracker;
+
+typedef LockFreeTimeSpanTracker::Ptr LockFreeTimeSpanTrackerPtr;
+typedef LockFreeTimeSpanTracker::ConstPtr LockFreeTimeSpanTrackerConstPtr;
+typedef TscTimeSpanTracker::Ptr TscTimeSpanTrackerPtr;
+typedef TscTimeSpanTracker::ConstPtr TscTimeSpanTrackerConstPtr;
+
 }  // namespace realtime_utilities
 
 #endif  // REALTIME_UTILITIES_TIME_SPAN_TRACKER_H
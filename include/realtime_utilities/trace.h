@@ -0,0 +1,163 @@
+#ifndef REALTIME_UTILITIES_TRACE_H
+#define REALTIME_UTILITIES_TRACE_H
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <realtime_utilities/spsc_ring.h>
+#include <realtime_utilities/tsc_clock.h>
+
+// Scoped tracing zones, exported as Chrome Trace Event JSON (chrome://tracing,
+// ui.perfetto.dev):
+//
+//   realtime_utilities::trace::start("/tmp/control.json");
+//   ...
+//   void update()
+//   {
+//     REALTIME_UTILITIES_TRACE_ZONE("update");
+//     { REALTIME_UTILITIES_TRACE_ZONE("kinematics"); ... }
+//     { REALTIME_UTILITIES_TRACE_ZONE("dynamics"); ... }
+//   }
+//   ...
+//   realtime_utilities::trace::stop();
+//
+// A zone reads the tsc_clock when it is opened and closed, and pushes one
+// record into a ring of the calling thread: no lock, no allocation. Every
+// thread that records calls register_thread() at its set-up, which takes the
+// ring; the zones of threads that did not register are dropped and counted.
+// At thread exit the ring is retired, and once drained it is reused by the
+// next thread that registers, so short-lived threads do not pile up rings.
+// A background thread drains the rings into the file. Zone names must be
+// string literals, only the pointer is recorded. When a ring is full the
+// records are dropped and counted.
+//
+// The zones compile to nothing unless REALTIME_UTILITIES_ENABLE_TRACE is
+// defined to 1; otherwise they cost a relaxed load while tracing is stopped.
+// The CMake option of the same name defines it for the library and, through
+// the catkin config extras, for the packages that find realtime_utilities.
+
+#if !defined(REALTIME_UTILITIES_ENABLE_TRACE)
+#define REALTIME_UTILITIES_ENABLE_TRACE 0
+#endif
+
+#if !defined(REALTIME_UTILITIES_TRACE_RING_SIZE)
+#define REALTIME_UTILITIES_TRACE_RING_SIZE 4096
+#endif
+
+namespace realtime_utilities
+{
+
+namespace trace
+{
+
+// start recording and flushing the zones to path every flush_period_ms
+bool start(const std::string& path, long flush_period_ms = 100);
+// stop recording, flush what is left and close the file
+void stop();
+
+// pause/resume recording without closing the file
+void enable(bool on);
+inline bool enabled();
+
+// take a ring for the calling thread and name it in the trace; call it at
+// the initialization of every thread that records zones (it may lock and
+// allocate). Calling it again only renames the thread.
+void register_thread(const std::string& name);
+
+// records lost because a ring was full or the thread was not registered
+std::size_t dropped();
+
+namespace internal
+{
+
+struct record
+{
+  const char* name;
+  int64_t     begin;
+  int64_t     end;
+};
+
+struct thread_buffer
+{
+  spsc_ring<record, REALTIME_UTILITIES_TRACE_RING_SIZE> ring;
+  std::atomic<std::size_t>                              dropped{0};
+  std::atomic<bool>                                     retired{false};  // the thread has exited
+  std::string                                           name;
+  long                                                  tid;
+
+  // spsc_ring is cache line aligned, C++14 new does not honour it
+  static void* operator new(std::size_t size)
+  {
+    void* p = nullptr;
+    if (posix_memalign(&p, cache_line_size, size) != 0)
+      throw std::bad_alloc();
+    return p;
+  }
+  static void operator delete(void* p)
+  {
+    free(p);
+  }
+};
+
+extern std::atomic<bool> enabled;
+extern std::atomic<std::size_t> unregistered;  // records of threads without a ring
+
+inline thread_buffer*& local_buffer()
+{
+  static thread_local thread_buffer* buffer = nullptr;
+  return buffer;
+}
+
+inline void push(const char* name, int64_t begin, int64_t end)
+{
+  thread_buffer* b = local_buffer();
+  if (!b)
+  {
+    unregistered.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  if (!b->ring.push(record{name, begin, end}))
+    b->dropped.store(b->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+}  // namespace internal
+
+inline bool enabled()
+{
+  return internal::enabled.load(std::memory_order_relaxed);
+}
+
+class zone
+{
+public:
+  explicit zone(const char* name) : name_(name), begin_(enabled() ? tsc_clock::ticks_unordered() : 0) {}
+  ~zone()
+  {
+    if (begin_ != 0)
+      internal::push(name_, begin_, tsc_clock::ticks());
+  }
+  zone(const zone&) = delete;
+  zone& operator=(const zone&) = delete;
+
+private:
+  const char* name_;
+  int64_t     begin_;
+};
+
+}  // namespace trace
+
+}  // namespace realtime_utilities
+
+#define REALTIME_UTILITIES_TRACE_CONCAT_(a, b) a##b
+#define REALTIME_UTILITIES_TRACE_CONCAT(a, b) REALTIME_UTILITIES_TRACE_CONCAT_(a, b)
+
+#if REALTIME_UTILITIES_ENABLE_TRACE
+#define REALTIME_UTILITIES_TRACE_ZONE(name) \
+  realtime_utilities::trace::zone REALTIME_UTILITIES_TRACE_CONCAT(realtime_utilities_trace_zone_, __LINE__)(name)
+#else
+#define REALTIME_UTILITIES_TRACE_ZONE(name) (void)0
+#endif
+
+#endif  // REALTIME_UTILITIES_TRACE_H
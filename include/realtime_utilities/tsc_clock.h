@@ -0,0 +1,147 @@
+#ifndef REALTIME_UTILITIES_TSC_CLOCK_H
+#define REALTIME_UTILITIES_TSC_CLOCK_H
+
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+namespace realtime_utilities
+{
+
+// Tick sources for the trackers: ticks() returns a raw int64 counter, which
+// is converted in seconds only when the statistics are reported.
+
+// std::chrono::steady_clock, 1 tick = 1 ns
+struct steady_tick_clock
+{
+  static int64_t ticks()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+  static double ticks_per_second()
+  {
+    return 1e9;
+  }
+  static double to_seconds(int64_t ticks)
+  {
+    return 1e-9 * double(ticks);
+  }
+};
+
+// Time Stamp Counter of x86 cores: ticks() is a rdtscp, a few ns instead of
+// the vDSO clock_gettime() of steady_clock. The TSC is used only when the
+// cpu declares it invariant (constant rate in every P/C-state, synchronized
+// among cores, cpuid 0x80000007 EDX bit 8); otherwise, and on other
+// architectures, ticks() falls back to CLOCK_MONOTONIC in ns.
+//
+// The TSC rate is calibrated against CLOCK_MONOTONIC at the first use,
+// which takes calibration_ms: call tsc_clock::calibrate() at start-up,
+// before the RT loop.
+class tsc_clock
+{
+public:
+  enum { calibration_ms = 20 };
+
+  static int64_t ticks()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    if (state().use_tsc)
+    {
+      unsigned int aux;
+      return int64_t(__rdtscp(&aux));
+    }
+#endif
+    return monotonic_ns();
+  }
+
+  // the TSC read is not ordered with respect to the following instructions:
+  // cheaper than ticks(), for the start of a measured zone
+  static int64_t ticks_unordered()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    if (state().use_tsc)
+      return int64_t(__rdtsc());
+#endif
+    return monotonic_ns();
+  }
+
+  static double ticks_per_second()
+  {
+    return state().ticks_per_second;
+  }
+  static double to_seconds(int64_t ticks)
+  {
+    return double(ticks) / state().ticks_per_second;
+  }
+
+  // true if ticks() reads the TSC
+  static bool is_tsc()
+  {
+    return state().use_tsc;
+  }
+
+  static bool invariant_tsc()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007)
+      return false;
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return (edx & (1u << 8)) != 0;
+#else
+    return false;
+#endif
+  }
+
+  static void calibrate()
+  {
+    state();
+  }
+
+private:
+  struct calibration
+  {
+    bool   use_tsc;
+    double ticks_per_second;
+
+    calibration() : use_tsc(invariant_tsc()), ticks_per_second(1e9)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+      if (!use_tsc)
+        return;
+      unsigned int aux;
+      const int64_t t0 = monotonic_ns();
+      const uint64_t c0 = __rdtscp(&aux);
+      std::this_thread::sleep_for(std::chrono::milliseconds(calibration_ms));
+      const int64_t t1 = monotonic_ns();
+      const uint64_t c1 = __rdtscp(&aux);
+      if (t1 > t0 && c1 > c0)
+        ticks_per_second = 1e9 * double(c1 - c0) / double(t1 - t0);
+      else
+        use_tsc = false;
+#endif
+    }
+  };
+
+  static const calibration& state()
+  {
+    static const calibration c;
+    return c;
+  }
+
+  static int64_t monotonic_ns()
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+  }
+};
+
+}  // namespace realtime_utilities
+
+#endif  // REALTIME_UTILITIES_TSC_CLOCK_H
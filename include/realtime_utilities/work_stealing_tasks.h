@@ -0,0 +1,327 @@
+#ifndef REALTIME_UTILITIES__WORK_STEALING_TASKS__H
+#define REALTIME_UTILITIES__WORK_STEALING_TASKS__H
+
+#include <mutex>
+#include <future>
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <new>
+#include <memory>
+#include <cstdlib>
+#include <condition_variable>
+#include <realtime_utilities/realtime_utilities.h>
+#include <realtime_utilities/lockfree_queue.h>
+
+namespace realtime_utilities
+{
+
+#if !defined(REALTIME_UTILITIES_WS_DEQUE_SIZE)
+#define REALTIME_UTILITIES_WS_DEQUE_SIZE 1024
+#endif
+
+#if !defined(REALTIME_UTILITIES_WS_TASK_POOL_SIZE)
+#define REALTIME_UTILITIES_WS_TASK_POOL_SIZE 4096
+#endif
+
+// Work-stealing version of realtime_utilities::tasks, with the same interface.
+//
+// Each worker owns a lock-free deque, filled by the tasks queued from inside
+// the worker itself (LIFO, cache friendly), and a lock-free inbox, filled
+// round-robin by the tasks queued from the other threads. An idle worker
+// first drains its own queues, then steals from a random victim; after a
+// failed round it sleeps until a new task is queued. The only lock left is
+// the one used to put idle workers to sleep, and it is taken by the
+// producers only when somebody is actually sleeping.
+//
+// The queued tasks live in a pool of REALTIME_UTILITIES_WS_TASK_POOL_SIZE
+// nodes allocated with the pool, recycled through a lock-free free list;
+// when they are all in use, the task node is allocated on the heap.
+struct work_stealing_tasks
+{
+  typedef std::packaged_task<void()> task;
+
+  work_stealing_tasks()
+    : n_workers_(0), next_worker_(0), pending_(0), sleeping_(0), submitted_(0), nodes_(new node_pool()), injected_size_(0), stop_(false)
+  {
+  }
+  work_stealing_tasks(const work_stealing_tasks&) = delete;
+  work_stealing_tasks& operator=(const work_stealing_tasks&) = delete;
+
+  // queue( lambda ) will enqueue the lambda into the tasks for the threads
+  // to use.  A future of the type the lambda returns is given to let you get
+  // the result out.
+  template<class F, class R=std::result_of_t<F&()>>
+  std::future<R> queue(F&& f)
+  {
+    std::packaged_task<R()> p(std::forward<F>(f));
+    auto r = p.get_future();
+    submit(nodes_->acquire(task(std::move(p))));
+    return r;
+  }
+
+  // start N more threads in the thread pool.
+  void start(std::size_t N=1)
+  {
+    std::lock_guard<std::mutex> l(mtx_);
+    for (std::size_t i = 0; i < N && n_workers_ < REALTIME_UTILITIES_MAX_WORKERS; ++i)
+    {
+      const std::size_t id = n_workers_.load(std::memory_order_relaxed);
+      workers_[id].reset(new worker(id));
+      n_workers_.store(id + 1, std::memory_order_release);
+      finished_.push_back(std::async(std::launch::async, [this, id]{ thread_task(id); }));
+    }
+  }
+  // abort() cancels all non-started tasks, and tells every working thread
+  // stop running, and waits for them to finish up.
+  void abort()
+  {
+    cancel_pending();
+    finish();
+  }
+  // cancel_pending() merely cancels all non-started tasks:
+  void cancel_pending()
+  {
+    task* t;
+    while ((t = take(nullptr)) != nullptr)
+      nodes_->release(t);
+  }
+  // finish() lets the workers exit as soon as there is no queued task left:
+  void finish()
+  {
+    {
+      std::lock_guard<std::mutex> l(mtx_);
+      stop_.store(true, std::memory_order_seq_cst);
+    }
+    notifier_.notify_all();
+  }
+  // number of started workers
+  std::size_t size() const
+  {
+    return n_workers_.load(std::memory_order_acquire);
+  }
+
+  ~work_stealing_tasks()
+  {
+    finish();
+    for (auto& f : finished_)
+      f.wait();
+    cancel_pending();
+  }
+
+private:
+  // preallocated task nodes and their free list
+  struct node_pool
+  {
+    node_pool()
+    {
+      for (auto& n : nodes)
+        free_list.push(&n);
+    }
+
+    task* acquire(task&& t)
+    {
+      task* n = nullptr;
+      if (!free_list.pop(n))
+        return new task(std::move(t));
+      *n = std::move(t);
+      return n;
+    }
+    void release(task* n)
+    {
+      if (n >= nodes && n < nodes + REALTIME_UTILITIES_WS_TASK_POOL_SIZE)
+      {
+        *n = task();  // drop the shared state now, not at the next reuse
+        free_list.push(n);
+      }
+      else
+      {
+        delete n;
+      }
+    }
+
+    static void* operator new(std::size_t size)
+    {
+      void* p = nullptr;
+      if (posix_memalign(&p, alignof(node_pool), size) != 0)
+        throw std::bad_alloc();
+      return p;
+    }
+    static void operator delete(void* p)
+    {
+      free(p);
+    }
+
+    task                                                    nodes[REALTIME_UTILITIES_WS_TASK_POOL_SIZE];
+    mpmc_queue<task*, REALTIME_UTILITIES_WS_TASK_POOL_SIZE> free_list;
+  };
+
+  struct worker
+  {
+    explicit worker(std::size_t i) : id(i), seed(static_cast<uint32_t>(2654435761u * (i + 1))) {}
+
+    // the queues are cache-line aligned, which plain C++14 new does not honour
+    static void* operator new(std::size_t size)
+    {
+      void* p = nullptr;
+      if (posix_memalign(&p, alignof(worker), size) != 0)
+        throw std::bad_alloc();
+      return p;
+    }
+    static void operator delete(void* p)
+    {
+      free(p);
+    }
+
+    const std::size_t                                       id;
+    uint32_t                                                seed;   // victim selection, owner only
+    ws_deque<task*, REALTIME_UTILITIES_WS_DEQUE_SIZE>        local;  // owner pushes/pops, the others steal
+    mpmc_queue<task*, REALTIME_UTILITIES_WS_DEQUE_SIZE>      inbox;  // tasks queued by non-worker threads
+  };
+
+  static worker*& this_worker()
+  {
+    static thread_local worker* w = nullptr;
+    return w;
+  }
+  static work_stealing_tasks*& this_pool()
+  {
+    static thread_local work_stealing_tasks* p = nullptr;
+    return p;
+  }
+
+  void submit(task* t)
+  {
+    worker* self = this_pool() == this ? this_worker() : nullptr;
+    bool queued = self && self->local.push(t);
+    const std::size_t n = n_workers_.load(std::memory_order_acquire);
+    for (std::size_t i = 0; !queued && i < n; i++)
+    {
+      queued = workers_[next_worker_.fetch_add(1, std::memory_order_relaxed) % n]->inbox.push(t);
+    }
+    if (!queued)
+    {
+      // no worker started yet, or every inbox is full
+      std::lock_guard<std::mutex> l(mtx_);
+      injected_.push_back(t);
+      injected_size_.fetch_add(1, std::memory_order_seq_cst);
+    }
+    pending_.fetch_add(1, std::memory_order_seq_cst);
+    submitted_.fetch_add(1, std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_seq_cst) > 0)
+    {
+      std::lock_guard<std::mutex> l(mtx_);
+      notifier_.notify_one();
+    }
+  }
+
+  // own deque, own inbox, injected queue, then steal from a random victim
+  task* take(worker* self)
+  {
+    task* t = nullptr;
+    if (self && ((t = self->local.pop()) != nullptr || self->inbox.pop(t)))
+      return taken(t);
+
+    if (injected_size_.load(std::memory_order_seq_cst) > 0)
+    {
+      std::lock_guard<std::mutex> l(mtx_);
+      if (!injected_.empty())
+      {
+        t = injected_.front();
+        injected_.pop_front();
+        injected_size_.fetch_sub(1, std::memory_order_seq_cst);
+        return taken(t);
+      }
+    }
+
+    const std::size_t n = n_workers_.load(std::memory_order_acquire);
+    const std::size_t first = self ? next_victim(self) % n : 0;
+    for (std::size_t i = 0; i < n; i++)
+    {
+      worker* victim = workers_[(first + i) % n].get();
+      if (victim == self)
+        continue;
+      if ((t = victim->local.steal()) != nullptr || victim->inbox.pop(t))
+        return taken(t);
+    }
+    return nullptr;
+  }
+
+  task* taken(task* t)
+  {
+    // the last queued task of a finishing pool: wake the workers that are
+    // sleeping, they can exit
+    if (pending_.fetch_sub(1, std::memory_order_seq_cst) == 1 && stop_.load(std::memory_order_seq_cst)
+        && sleeping_.load(std::memory_order_seq_cst) > 0)
+    {
+      std::lock_guard<std::mutex> l(mtx_);
+      notifier_.notify_all();
+    }
+    return t;
+  }
+
+  bool finished() const
+  {
+    return stop_.load(std::memory_order_seq_cst) && pending_.load(std::memory_order_seq_cst) == 0;
+  }
+
+  static uint32_t next_victim(worker* w)
+  {
+    // xorshift32
+    w->seed ^= w->seed << 13;
+    w->seed ^= w->seed >> 17;
+    w->seed ^= w->seed << 5;
+    return w->seed;
+  }
+
+  void thread_task(std::size_t id)
+  {
+    worker* self = workers_[id].get();
+    this_worker() = self;
+    this_pool() = this;
+    while (true)
+    {
+      // a task queued after this read wakes the worker up, even if the
+      // round below misses it
+      const uint64_t submitted = submitted_.load(std::memory_order_seq_cst);
+      task* t = take(self);
+      if (t)
+      {
+        (*t)();
+        nodes_->release(t);
+        continue;
+      }
+      // nothing to take or steal: the tasks still pending, if any, are held
+      // by running workers, so sleep instead of retrying the steal
+      std::unique_lock<std::mutex> locker(mtx_);
+      sleeping_.fetch_add(1, std::memory_order_seq_cst);
+      notifier_.wait(locker, [&]{ return submitted_.load(std::memory_order_seq_cst) != submitted || finished(); });
+      sleeping_.fetch_sub(1, std::memory_order_seq_cst);
+      if (finished())
+        break;
+    }
+    this_worker() = nullptr;
+    this_pool() = nullptr;
+  }
+
+  std::unique_ptr<worker>        workers_[REALTIME_UTILITIES_MAX_WORKERS];
+  std::atomic<std::size_t>       n_workers_;
+  std::atomic<std::size_t>       next_worker_;
+  std::atomic<int64_t>           pending_;
+  std::atomic<int>               sleeping_;
+  std::atomic<uint64_t>          submitted_;
+  std::unique_ptr<node_pool>     nodes_;
+
+  std::mutex                     mtx_;
+  std::condition_variable        notifier_;
+  std::deque<task*>              injected_;
+  std::atomic<std::size_t>       injected_size_;
+  std::atomic<bool>              stop_;
+
+  // this holds futures representing the worker threads being done:
+  std::vector<std::future<void>> finished_;
+};
+
+}  // namespace realtime_utilities
+
+#endif   // REALTIME_UTILITIES__WORK_STEALING_TASKS__H
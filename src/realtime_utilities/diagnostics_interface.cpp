@@ -3,7 +3,9 @@
 #include <algorithm>
 #include <mutex>
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/date_time/c_local_time_adjustor.hpp>
 #include <realtime_utilities/diagnostics_interface.h>
+#include <realtime_utilities/parallel_computing.h>
 
 namespace realtime_utilities
 {
@@ -50,9 +52,72 @@ void DiagnosticsInterface::addDiagnosticsMessage(const std::string& level
   diagnostic_.status.push_back(diag);
 }
 
+DiagnosticsInterface::MessageId DiagnosticsInterface::registerDiagnosticsMessage(const std::string& summary
+                                                                                , const std::vector<std::string>& value_names)
+{
+  std::lock_guard<std::mutex> lock(mtx_);
+  rt_messages_.push_back(RegisteredMessage{summary, value_names});
+  return MessageId(rt_messages_.size() - 1);
+}
+
+bool DiagnosticsInterface::postDiagnosticsMessage(const Level& level, const MessageId& id, std::initializer_list<double> values)
+{
+  RtMessage msg;
+  msg.level    = level;
+  msg.id       = id;
+  msg.n_values = 0;
+  for (const double& v : values)
+  {
+    if (msg.n_values == REALTIME_UTILITIES_DIAGNOSTICS_MAX_VALUES)
+      break;
+    msg.values[msg.n_values++] = v;
+  }
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  msg.stamp = int64_t(now.tv_sec) * 1000000000 + now.tv_nsec;
+
+  if (!rt_queue_->queue.push(msg))
+  {
+    rt_queue_->dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+void DiagnosticsInterface::drainRtMessages()
+{
+  RtMessage msg;
+  while (rt_queue_->queue.pop(msg))
+  {
+    if (msg.id >= rt_messages_.size())
+      continue;
+    const RegisteredMessage& reg = rt_messages_[msg.id];
+
+    diagnostic_msgs::DiagnosticStatus diag;
+    diag.name        = name_id_;
+    diag.hardware_id = hardware_id_;
+    diag.level       = static_cast<uint8_t>(msg.level);
+    diag.message     = reg.summary;
+    for (uint32_t i = 0; i < msg.n_values; i++)
+    {
+      diagnostic_msgs::KeyValue kv;
+      kv.key   = i < reg.value_names.size() ? reg.value_names[i] : "value " + std::to_string(i);
+      kv.value = std::to_string(msg.values[i]);
+      diag.message += " " + kv.key + ": " + kv.value;
+      diag.values.push_back(kv);
+    }
+    const boost::posix_time::ptime stamp = boost::date_time::c_local_adjustor<boost::posix_time::ptime>::utc_to_local(
+                                             boost::posix_time::from_time_t(msg.stamp / 1000000000)
+                                           + boost::posix_time::microseconds((msg.stamp % 1000000000) / 1000));
+    diag.message += " [" + boost::posix_time::to_iso_string(stamp.time_of_day()) + "]";
+    diagnostic_.status.push_back(diag);
+  }
+}
+
 void DiagnosticsInterface::diagnostics(diagnostic_updater::DiagnosticStatusWrapper &stat, int level)
 {
   std::lock_guard<std::mutex> lock(mtx_);
+  drainRtMessages();
   boost::posix_time::ptime my_posix_time = boost::posix_time::microsec_clock::local_time();
 
   stat.hardware_id = hardware_id_;
@@ -131,17 +196,84 @@ void DiagnosticsInterface::diagnosticsPerformance(diagnostic_updater::Diagnostic
     k.value = to_string_fix(tracker.second->getMean())
             + std::string(" [ ") + to_string_fix(tracker.second->getMin()) + " - "
             + to_string_fix(tracker.second->getMax()) + std::string(" ] ")
-            + std::string("Missed: ") + std::to_string(tracker.second->getMissedCycles())
+            + std::string("StdDev: ") + to_string_fix(tracker.second->getStdDev())
+            + std::string(" Ewma: ") + to_string_fix(tracker.second->getEwma())
+            + std::string(" Missed: ") + std::to_string(tracker.second->getMissedCycles())
             + std::string("/") + std::to_string(tracker.second->getTotalCycles());
 
     stat.add(k.key, k.value);
   }
+  for(auto const & pool : tasks_pools_ )
+  {
+    const realtime_utilities::tasks_stats s = pool.second->statistics();
+    const std::string prefix = timer_id_ + " " + pool.first;
+    auto us = [](const int64_t ns) { return to_string_fix(1e-3 * ns, 1); };
+
+    stat.add(prefix + " queue length", std::to_string(s.queued)
+            + std::string(" [ p99: ") + std::to_string(s.queue_length.p99)
+            + std::string(" max: ") + std::to_string(s.queue_length.max) + " ]");
+    stat.add(prefix + " latency [us]", to_string_fix(1e-3 * s.latency.mean, 1)
+            + std::string(" [ p50: ") + us(s.latency.p50) + " p99: " + us(s.latency.p99)
+            + " max: " + us(s.latency.max) + " ]");
+    stat.add(prefix + " run time [us]", to_string_fix(1e-3 * s.run.mean, 1)
+            + std::string(" [ p50: ") + us(s.run.p50) + " p99: " + us(s.run.p99)
+            + " max: " + us(s.run.max) + " ]");
+    std::string workers;
+    for (std::size_t i = 0; i < s.workers.size(); i++)
+    {
+      workers += (i ? " " : "") + to_string_fix(100.0 * s.workers[i].utilisation, 1);
+    }
+    stat.add(prefix + " utilisation [%]", to_string_fix(100.0 * s.utilisation, 1)
+            + std::string(" [ ") + workers + " ] Jobs: " + std::to_string(s.jobs));
+  }
+  for(auto const & profiler : cycle_profilers_ )
+  {
+    const realtime_utilities::CycleProfiler::Statistics s = profiler.second->getStatistics();
+    const std::string prefix = timer_id_ + " " + profiler.first;
+    auto us = [](const double ns) { return to_string_fix(1e-3 * ns, 1); };
+
+    stat.add(prefix + " cycle [us]", std::string("Busy: ") + us(s.busy.mean)
+            + std::string(" [ p99: ") + us(s.busy.p99) + " max: " + us(s.busy.max) + " ]"
+            + std::string(" Slack: ") + us(s.slack.mean) + " [ min: " + us(s.slack.min) + " ]"
+            + std::string(" Overruns: ") + std::to_string(s.overruns) + "/" + std::to_string(s.cycles));
+    for (const auto& p : s.phases)
+    {
+      stat.add(prefix + " " + p.name + " [us]", us(p.duration.mean)
+              + std::string(" [ p50: ") + us(p.duration.p50) + " p99: " + us(p.duration.p99)
+              + " max: " + us(p.duration.max) + " ]"
+              + std::string(" Share: ") + to_string_fix(100.0 * p.share, 1) + "%"
+              + std::string(" In overruns: ") + us(p.overrun_mean));
+    }
+  }
 }
 
 void DiagnosticsInterface::addTimeTracker(const std::string& id, const double& period)
 {
-  time_span_tracker_[id].reset(new realtime_utilities::TimeSpanTracker(int(10.0/period), period));
+  auto it = tracker_handles_.find(id);
+  if (it != tracker_handles_.end())
+  {
+    // a fresh tracker at the new period, in the same slot: the handle stays valid
+    (*trackers_)[it->second].reset(std::max(1, int(1.0/period)), period);
+    period_[id] = period;
+    return;
+  }
+  trackers_->emplace_back(std::max(1, int(1.0/period)), period);
+  // the shared pointers handed out by timeSpanTracker(id) keep the storage alive
+  time_span_tracker_[id] = realtime_utilities::TimeSpanTrackerPtr(trackers_, &trackers_->back());
   period_[id] = period;
+  tracker_handles_[id] = trackers_->size() - 1;
+}
+
+void DiagnosticsInterface::addTasksPool(const std::string& id, const std::shared_ptr<const realtime_utilities::tasks>& pool)
+{
+  std::lock_guard<std::mutex> lock(mtx_);
+  tasks_pools_[id] = pool;
+}
+
+void DiagnosticsInterface::addCycleProfiler(const std::string& id, const realtime_utilities::CycleProfilerPtr& profiler)
+{
+  std::lock_guard<std::mutex> lock(mtx_);
+  cycle_profilers_[id] = profiler;
 }
 
 }
\ No newline at end of file
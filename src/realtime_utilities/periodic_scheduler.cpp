@@ -0,0 +1,201 @@
+#include <cstring>
+#include <algorithm>
+#include <realtime_utilities/periodic_scheduler.h>
+
+namespace realtime_utilities
+{
+
+PeriodicScheduler::~PeriodicScheduler()
+{
+  stop();
+}
+
+bool PeriodicScheduler::addTask(const TaskConfig& config, std::function<void()> callback)
+{
+  if (running_ || config.period_ns <= 0 || config.phase_ns < 0 || !callback || task(config.name))
+  {
+    printf("PeriodicScheduler: task '%s' not added (scheduler running, invalid period/phase or duplicated name).\n", config.name.c_str());
+    return false;
+  }
+  std::unique_ptr<Task> t(new Task());
+  t->config   = config;
+  t->callback = std::move(callback);
+  t->tracker.reset(new realtime_utilities::TimeSpanTracker(std::max(1, int(1.0e9 / config.period_ns)), 1e-9 * config.period_ns));
+  t->overruns = 0;
+  t->reported = 0;
+  tasks_.push_back(std::move(t));
+  return true;
+}
+
+void PeriodicScheduler::configureThread(const std::string& thread, const worker_spec& spec)
+{
+  specs_[thread] = spec;
+}
+
+bool PeriodicScheduler::start()
+{
+  if (running_ || tasks_.empty())
+    return false;
+
+  // group the tasks by thread
+  threads_.clear();
+  std::map<std::string, Thread*> named;
+  for (auto& t : tasks_)
+  {
+    Thread* thread = nullptr;
+    if (!t->config.thread.empty() && named.count(t->config.thread))
+    {
+      thread = named.at(t->config.thread);
+    }
+    else
+    {
+      threads_.emplace_back(new Thread());
+      thread = threads_.back().get();
+      thread->name = t->config.thread.empty() ? t->config.name : t->config.thread;
+      thread->scheduler = this;
+      if (specs_.count(thread->name))
+        thread->spec = specs_.at(thread->name);
+      if (!t->config.thread.empty())
+        named[t->config.thread] = thread;
+    }
+    thread->tasks.push_back(t.get());
+  }
+
+  // common time reference for all the phases, a bit in the future to let
+  // the threads start
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  timer_add(&start, 10000000);
+  for (auto& t : tasks_)
+  {
+    t->pinfo.period_ns   = t->config.period_ns;
+    t->pinfo.next_period = start;
+    timer_add(&t->pinfo.next_period, t->config.phase_ns);
+  }
+
+  running_ = true;
+  for (auto& thread : threads_)
+  {
+    Thread* th = thread.get();
+    int err = create_rt_thread(&thread->handle, thread->spec, [th]{ th->scheduler->loop(th); }, "PeriodicScheduler: thread '" + thread->name + "'");
+    if (err != 0)
+    {
+      printf("PeriodicScheduler: error in creating thread '%s': %s\n", thread->name.c_str(), strerror(err));
+      stop();
+      return false;
+    }
+    thread->started = true;
+  }
+  return true;
+}
+
+void PeriodicScheduler::stop()
+{
+  running_ = false;
+  for (auto& thread : threads_)
+  {
+    if (thread->started)
+    {
+      pthread_join(thread->handle, nullptr);
+      thread->started = false;
+    }
+  }
+  reportOverruns();
+}
+
+size_t PeriodicScheduler::reportOverruns()
+{
+  size_t ret = 0;
+  for (auto& t : tasks_)
+  {
+    if (t->config.overrun != WARN)
+      continue;
+    const size_t overruns = t->overruns.load();
+    const size_t skipped = overruns - t->reported.exchange(overruns);
+    if (skipped > 0)
+    {
+      printf("PeriodicScheduler: task '%s' overrun, %zu activation(s) skipped.\n", t->config.name.c_str(), skipped);
+    }
+    ret += skipped;
+  }
+  return ret;
+}
+
+realtime_utilities::TimeSpanTrackerPtr PeriodicScheduler::tracker(const std::string& name) const
+{
+  Task* t = task(name);
+  return t ? t->tracker : nullptr;
+}
+
+size_t PeriodicScheduler::overruns(const std::string& name) const
+{
+  Task* t = task(name);
+  return t ? t->overruns.load() : 0;
+}
+
+PeriodicScheduler::Task* PeriodicScheduler::task(const std::string& name) const
+{
+  for (auto& t : tasks_)
+  {
+    if (t->config.name == name)
+      return t.get();
+  }
+  return nullptr;
+}
+
+void PeriodicScheduler::loop(Thread* thread)
+{
+  while (running_)
+  {
+    // the next activation among the tasks of this thread
+    Task* t = thread->tasks.front();
+    for (Task* other : thread->tasks)
+    {
+      if (timer_greater_than(&t->pinfo.next_period, &other->pinfo.next_period))
+        t = other;
+    }
+
+    timer_wait_rest_of_period(&t->pinfo.next_period);
+    if (!running_)
+      break;
+
+    struct timespec begin;
+    if (t->config.overrun == CATCH_UP)
+      clock_gettime(CLOCK_MONOTONIC, &begin);
+    t->tracker->tick();
+    t->callback();
+    t->tracker->tock();
+
+    uint32_t missed = 0;
+    switch (t->config.overrun)
+    {
+    case CATCH_UP:
+    {
+      // the activations that fell due while this one was running, i.e. the
+      // (now - next) / period whole periods minus those already late when it
+      // started, counted by the previous activations: they run back to back
+      struct timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      const int64_t late_end   = timer_difference_ns(&now, &t->pinfo.next_period);
+      const int64_t late_begin = timer_difference_ns(&begin, &t->pinfo.next_period);
+      if (late_end > 0)
+        missed = uint32_t(late_end / t->pinfo.period_ns - std::max<int64_t>(late_begin, 0) / t->pinfo.period_ns);
+      timer_add(&t->pinfo.next_period, t->pinfo.period_ns);
+    }
+    break;
+    case SKIP:
+    case WARN:
+      missed = timer_inc_period(&t->pinfo);
+      break;
+    }
+
+    // no printf from the RT thread: the WARN tasks are reported by
+    // reportOverruns()
+    if (missed > 0)
+    {
+      t->overruns += missed;
+    }
+  }
+}
+
+}  // namespace realtime_utilities
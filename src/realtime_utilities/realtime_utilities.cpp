@@ -1,4 +1,6 @@
 #include <iostream>
+#include <memory>
+#include <cstring>
 #include <realtime_utilities/realtime_utilities.h>
 
 #include <arpa/inet.h>
@@ -26,6 +28,113 @@ bool setprio(int prio, int sched)
   return true;
 }
 
+thread_usage_sampler::thread_usage_sampler() : has_prev_(false), reset_requested_(false)
+{
+  clear();
+}
+
+void thread_usage_sampler::reset()
+{
+  reset_requested_.store(true, std::memory_order_release);
+}
+
+void thread_usage_sampler::clear()
+{
+  for (int i = 0; i < FIELDS; i++)
+  {
+    last_[i].store(0, std::memory_order_relaxed);
+    total_[i].store(0, std::memory_order_relaxed);
+    max_[i].store(0, std::memory_order_relaxed);
+  }
+  cycles_.store(0, std::memory_order_relaxed);
+  preempted_.store(0, std::memory_order_relaxed);
+  faulted_.store(0, std::memory_order_relaxed);
+  has_prev_ = false;
+}
+
+bool thread_usage_sampler::sample()
+{
+  struct rusage usage;
+  struct timespec cpu;
+  if (getrusage(RUSAGE_THREAD, &usage) != 0 || clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu) != 0)
+  {
+    return false;
+  }
+  int64_t now[FIELDS];
+  now[MINOR_FAULTS]         = usage.ru_minflt;
+  now[MAJOR_FAULTS]         = usage.ru_majflt;
+  now[VOLUNTARY_SWITCHES]   = usage.ru_nvcsw;
+  now[INVOLUNTARY_SWITCHES] = usage.ru_nivcsw;
+  now[CPU_TIME]             = timer_to_ns(&cpu);
+
+  if (reset_requested_.exchange(false, std::memory_order_acquire))
+  {
+    clear();
+  }
+
+  if (has_prev_)
+  {
+    for (int i = 0; i < FIELDS; i++)
+    {
+      const int64_t d = now[i] - prev_[i];
+      last_[i].store(d, std::memory_order_relaxed);
+      total_[i].store(total_[i].load(std::memory_order_relaxed) + d, std::memory_order_relaxed);
+      if (d > max_[i].load(std::memory_order_relaxed))
+        max_[i].store(d, std::memory_order_relaxed);
+    }
+    cycles_.store(cycles_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (now[INVOLUNTARY_SWITCHES] > prev_[INVOLUNTARY_SWITCHES])
+      preempted_.store(preempted_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (now[MINOR_FAULTS] > prev_[MINOR_FAULTS] || now[MAJOR_FAULTS] > prev_[MAJOR_FAULTS])
+      faulted_.store(faulted_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+  for (int i = 0; i < FIELDS; i++)
+    prev_[i] = now[i];
+  has_prev_ = true;
+  return true;
+}
+
+thread_usage thread_usage_sampler::to_usage(const std::atomic<int64_t>* v)
+{
+  thread_usage ret;
+  ret.minor_faults         = v[MINOR_FAULTS].load(std::memory_order_relaxed);
+  ret.major_faults         = v[MAJOR_FAULTS].load(std::memory_order_relaxed);
+  ret.voluntary_switches   = v[VOLUNTARY_SWITCHES].load(std::memory_order_relaxed);
+  ret.involuntary_switches = v[INVOLUNTARY_SWITCHES].load(std::memory_order_relaxed);
+  ret.cpu_time_ns          = v[CPU_TIME].load(std::memory_order_relaxed);
+  return ret;
+}
+
+thread_usage thread_usage_sampler::last() const
+{
+  return to_usage(last_);
+}
+
+thread_usage thread_usage_sampler::total() const
+{
+  return to_usage(total_);
+}
+
+thread_usage thread_usage_sampler::max() const
+{
+  return to_usage(max_);
+}
+
+size_t thread_usage_sampler::cycles() const
+{
+  return cycles_.load(std::memory_order_relaxed);
+}
+
+size_t thread_usage_sampler::preempted_cycles() const
+{
+  return preempted_.load(std::memory_order_relaxed);
+}
+
+size_t thread_usage_sampler::faulted_cycles() const
+{
+  return faulted_.load(std::memory_order_relaxed);
+}
+
 bool show_new_pagefault_count(const char* logtext, const char* allowed_maj, const char* allowed_min)
 {
   static int last_majflt = 0, last_minflt = 0;
@@ -59,6 +168,91 @@ bool prove_thread_stack_use_is_safe(size_t  stacksize)
   return show_new_pagefault_count("Caused by using thread stack", "0", "0");
 }
 
+namespace
+{
+struct rt_thread_context
+{
+  worker_spec           spec;
+  std::function<void()> fn;
+  std::string           who;
+};
+
+// Same stack walk as prove_thread_stack_use_is_safe(), without the report:
+// the workers start together, and show_new_pagefault_count() prints and
+// keeps its reference counts in statics.
+void prefault_stack(size_t stacksize)
+{
+  volatile char buffer[stacksize];
+  const size_t page = sysconf(_SC_PAGESIZE);
+  for (size_t i = 0; i < stacksize; i += page)
+  {
+    buffer[i] = i;
+  }
+}
+
+void* rt_thread_entry(void* arg)
+{
+  std::unique_ptr<rt_thread_context> ctx(static_cast<rt_thread_context*>(arg));
+  if (ctx->spec.sched != SCHED_OTHER || ctx->spec.prio != 0)
+  {
+    if (!setprio(ctx->spec.prio, ctx->spec.sched))
+    {
+      printf("%s: error in setprio (policy %d, priority %d), the thread keeps the default scheduling.\n", ctx->who.c_str(), ctx->spec.sched, ctx->spec.prio);
+    }
+  }
+  if (ctx->spec.stack_size > 0)
+  {
+    prefault_stack(ctx->spec.stack_size);
+  }
+  ctx->fn();
+  return nullptr;
+}
+}  // namespace
+
+int create_rt_thread(pthread_t* thread, const worker_spec& spec, std::function<void()> fn, const std::string& who)
+{
+  std::unique_ptr<rt_thread_context> ctx(new rt_thread_context{spec, std::move(fn), who});
+
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  int err = 0;
+  if (spec.stack_size > 0)
+  {
+    // the pre-fault buffer lives on the stack itself: leave some margin
+    err = pthread_attr_setstacksize(&attr, spec.stack_size + PTHREAD_STACK_MIN);
+    if (err != 0)
+    {
+      printf("%s: error in setting the stack size to %zu bytes: %s, the thread keeps the default stack.\n", who.c_str(), spec.stack_size, strerror(err));
+    }
+  }
+  if (!spec.cpus.empty())
+  {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (int cpu : spec.cpus)
+    {
+      if (cpu < 0 || cpu >= CPU_SETSIZE)
+      {
+        printf("%s: invalid cpu %d in the thread affinity, ignored.\n", who.c_str(), cpu);
+        continue;
+      }
+      CPU_SET(cpu, &cpuset);
+    }
+    err = CPU_COUNT(&cpuset) > 0 ? pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &cpuset) : EINVAL;
+    if (err != 0)
+    {
+      printf("%s: error in setting the thread affinity: %s, the thread can run on any cpu.\n", who.c_str(), strerror(err));
+    }
+  }
+  err = pthread_create(thread, &attr, &rt_thread_entry, ctx.get());
+  pthread_attr_destroy(&attr);
+  if (err == 0)
+  {
+    ctx.release();
+  }
+  return err;
+}
+
 /*************************************************************/
 
 bool error(int at)
@@ -236,12 +430,11 @@ void timer_periodic_init(period_info *pinfo, long period_ns)
   clock_gettime(CLOCK_MONOTONIC, &(pinfo->next_period));
 }
 
-int timer_wait_rest_of_period(struct timespec *ts)
+namespace
 {
-  // int ret = timer_inc_period(pinfo);
 
-  /* for simplicity, ignoring possibilities of signal wakes */
-  int err = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, ts, NULL);
+int report_sleep_error(int err)
+{
   switch (err)
   {
   case EFAULT :
@@ -260,6 +453,52 @@ int timer_wait_rest_of_period(struct timespec *ts)
   return err;
 }
 
+}  // namespace
+
+wakeup_stats wakeup_recorder::statistics() const
+{
+  wakeup_stats ret;
+  ret.latency  = latency.summarize();
+  ret.overruns = overruns.load(std::memory_order_relaxed);
+  return ret;
+}
+
+void wakeup_recorder::reset()
+{
+  latency.reset();
+  overruns.store(0, std::memory_order_relaxed);
+}
+
+int timer_wait_rest_of_period(struct timespec *ts)
+{
+  // int ret = timer_inc_period(pinfo);
+
+  /* for simplicity, ignoring possibilities of signal wakes */
+  return report_sleep_error(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, ts, NULL));
+}
+
+int timer_wait_rest_of_period(struct timespec *ts, wakeup_recorder* recorder)
+{
+  if (!recorder)
+    return timer_wait_rest_of_period(ts);
+
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  const bool overrun = timer_greater_than(&now, ts);
+
+  int err = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, ts, NULL);
+  if (overrun)
+  {
+    recorder->overruns.store(recorder->overruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+  else if (err == 0)
+  {
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    recorder->latency.record(timer_difference_ns(&now, ts));
+  }
+  return report_sleep_error(err);
+}
+
 
 void timer_add(struct timespec *ts, int64_t addtime)
 {
@@ -0,0 +1,275 @@
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <condition_variable>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <realtime_utilities/trace.h>
+
+namespace realtime_utilities
+{
+
+namespace trace
+{
+
+namespace internal
+{
+
+std::atomic<bool> enabled(false);
+std::atomic<std::size_t> unregistered(0);
+
+namespace
+{
+
+struct flusher
+{
+  std::mutex                                  mtx;
+  std::vector<std::unique_ptr<thread_buffer>> buffers;
+  std::vector<bool>                           named;  // thread_name metadata already written
+  std::vector<thread_buffer*>                 free;   // drained rings of exited threads
+
+  std::mutex                                  file_mtx;
+  FILE*                                       file = nullptr;
+  bool                                        first = true;
+  int64_t                                     origin = 0;
+
+  std::thread                                 thread;
+  std::mutex                                  run_mtx;
+  std::condition_variable                     run_cv;
+  bool                                        running = false;
+
+  // trace::stop() not called before exit
+  ~flusher()
+  {
+    {
+      std::lock_guard<std::mutex> lock(run_mtx);
+      running = false;
+    }
+    run_cv.notify_all();
+    if (thread.joinable())
+      thread.join();
+    if (file)
+    {
+      fputs("\n]}\n", file);
+      fclose(file);
+    }
+  }
+};
+
+flusher& instance()
+{
+  static flusher f;
+  return f;
+}
+
+void write_string(FILE* file, const char* s)
+{
+  fputc('"', file);
+  for (; *s; s++)
+  {
+    if (*s == '"' || *s == '\\')
+      fputc('\\', file);
+    if (static_cast<unsigned char>(*s) >= 0x20)
+      fputc(*s, file);
+  }
+  fputc('"', file);
+}
+
+void separator(flusher& f)
+{
+  fputs(f.first ? "\n" : ",\n", f.file);
+  f.first = false;
+}
+
+// drain the ring of one thread
+void drain(flusher& f, thread_buffer& b, std::vector<bool>::reference named, bool write, long pid)
+{
+  if (!write || !f.file)
+  {
+    b.ring.clear();
+    return;
+  }
+  if (!named && !b.name.empty())
+  {
+    separator(f);
+    fprintf(f.file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%ld,\"args\":{\"name\":", pid, b.tid);
+    write_string(f.file, b.name.c_str());
+    fputs("}}", f.file);
+    named = true;
+  }
+  record r;
+  while (b.ring.pop(r))
+  {
+    separator(f);
+    fputs("{\"name\":", f.file);
+    write_string(f.file, r.name);
+    fprintf(f.file, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%ld,\"tid\":%ld}",
+            1e6 * tsc_clock::to_seconds(r.begin - f.origin), 1e6 * tsc_clock::to_seconds(r.end - r.begin), pid, b.tid);
+  }
+}
+
+// drain every ring into the file (or just discard the records), and recycle
+// the rings of the exited threads
+void drain(flusher& f, bool write)
+{
+  std::lock_guard<std::mutex> file_lock(f.file_mtx);
+  std::lock_guard<std::mutex> lock(f.mtx);
+  const long pid = getpid();
+  for (std::size_t i = 0; i < f.buffers.size(); i++)
+  {
+    thread_buffer& b = *f.buffers[i];
+    // read before the ring: once retired, the thread pushes no more records
+    const bool retired = b.retired.load(std::memory_order_acquire);
+    drain(f, b, f.named[i], write, pid);
+    if (retired)
+    {
+      b.retired.store(false, std::memory_order_relaxed);
+      f.free.push_back(&b);
+    }
+  }
+  if (write && f.file)
+    fflush(f.file);
+}
+
+void flush_loop(long period_ms)
+{
+  flusher& f = instance();
+  std::unique_lock<std::mutex> l(f.run_mtx);
+  while (f.running)
+  {
+    f.run_cv.wait_for(l, std::chrono::milliseconds(period_ms));
+    l.unlock();
+    drain(f, true);
+    l.lock();
+  }
+}
+
+// retires the ring of the thread at its exit
+struct thread_exit
+{
+  ~thread_exit()
+  {
+    thread_buffer*& local = local_buffer();
+    if (local)
+      local->retired.store(true, std::memory_order_release);
+    local = nullptr;
+  }
+};
+
+}  // namespace
+
+}  // namespace internal
+
+bool start(const std::string& path, long flush_period_ms)
+{
+  internal::flusher& f = internal::instance();
+  stop();
+  {
+    std::lock_guard<std::mutex> lock(f.file_mtx);
+    f.file = fopen(path.c_str(), "w");
+    if (!f.file)
+    {
+      printf("trace: error in opening '%s'.\n", path.c_str());
+      return false;
+    }
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", f.file);
+    f.first = true;
+    f.origin = tsc_clock::ticks();
+  }
+  internal::drain(f, false);
+  {
+    std::lock_guard<std::mutex> lock(f.mtx);
+    for (std::size_t i = 0; i < f.named.size(); i++)
+      f.named[i] = false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(f.run_mtx);
+    f.running = true;
+  }
+  f.thread = std::thread(&internal::flush_loop, flush_period_ms > 0 ? flush_period_ms : 100);
+  internal::enabled.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+void stop()
+{
+  internal::flusher& f = internal::instance();
+  internal::enabled.store(false, std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(f.run_mtx);
+    f.running = false;
+  }
+  f.run_cv.notify_all();
+  if (f.thread.joinable())
+    f.thread.join();
+
+  internal::drain(f, true);
+  std::lock_guard<std::mutex> lock(f.file_mtx);
+  if (f.file)
+  {
+    fputs("\n]}\n", f.file);
+    fclose(f.file);
+    f.file = nullptr;
+  }
+}
+
+void enable(bool on)
+{
+  internal::enabled.store(on, std::memory_order_relaxed);
+}
+
+void register_thread(const std::string& name)
+{
+  internal::flusher& f = internal::instance();
+  static thread_local internal::thread_exit exit_guard;
+  (void)exit_guard;
+
+  internal::thread_buffer*& local = internal::local_buffer();
+  std::lock_guard<std::mutex> lock(f.mtx);
+  if (!local)
+  {
+    // a retired ring with no record left needs no drain to be reused
+    for (auto& b : f.buffers)
+    {
+      if (b->retired.load(std::memory_order_acquire) && b->ring.empty())
+      {
+        b->retired.store(false, std::memory_order_relaxed);
+        f.free.push_back(b.get());
+      }
+    }
+    if (!f.free.empty())
+    {
+      local = f.free.back();
+      f.free.pop_back();
+    }
+    else
+    {
+      f.buffers.emplace_back(new internal::thread_buffer());
+      f.named.push_back(false);
+      local = f.buffers.back().get();
+    }
+    local->tid = syscall(SYS_gettid);
+  }
+  local->name = name.empty() ? std::string("thread") : name;
+  for (std::size_t i = 0; i < f.buffers.size(); i++)
+  {
+    if (f.buffers[i].get() == local)
+      f.named[i] = false;
+  }
+}
+
+std::size_t dropped()
+{
+  internal::flusher& f = internal::instance();
+  std::lock_guard<std::mutex> lock(f.mtx);
+  std::size_t ret = internal::unregistered.load(std::memory_order_relaxed);
+  for (const auto& b : f.buffers)
+    ret += b->dropped.load(std::memory_order_relaxed);
+  return ret;
+}
+
+}  // namespace trace
+
+}  // namespace realtime_utilities
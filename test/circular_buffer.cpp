@@ -0,0 +1,47 @@
+#include <iostream>
+#include <boost/circular_buffer.hpp>
+#include "realtime_utilities/circular_buffer.h"
+
+// min(), max() and mean() over a boost::circular_buffer, as used by the
+// windowed statistics of TimeSpanTracker: min() of positive spans must not
+// be 0.
+
+int main(int argc, char* argv[])
+{
+  boost::circular_buffer<double> cb(4);
+  if (realtime_utilities::min(cb) != 0.0 || realtime_utilities::max(cb) != 0.0 || realtime_utilities::mean(cb) != 0.0)
+  {
+    std::cout << "[ FAILED ] statistics of an empty buffer are not 0" << std::endl;
+    return 1;
+  }
+
+  for (double span : {0.0012, 0.0009, 0.0011, 0.0010, 0.0013})
+  {
+    cb.push_back(span);
+  }
+  // the window keeps the last 4 spans
+  if (realtime_utilities::min(cb) != 0.0009)
+  {
+    std::cout << "[ FAILED ] min() returned " << realtime_utilities::min(cb) << " instead of 0.0009" << std::endl;
+    return 1;
+  }
+  if (realtime_utilities::max(cb) != 0.0013)
+  {
+    std::cout << "[ FAILED ] max() returned " << realtime_utilities::max(cb) << " instead of 0.0013" << std::endl;
+    return 1;
+  }
+
+  boost::circular_buffer<int> negative(3);
+  for (int v : {-3, -7, -5})
+  {
+    negative.push_back(v);
+  }
+  if (realtime_utilities::min(negative) != -7)
+  {
+    std::cout << "[ FAILED ] min() of negative values returned " << realtime_utilities::min(negative) << std::endl;
+    return 1;
+  }
+
+  std::cout << "[ OK ]" << std::endl;
+  return 0;
+}
@@ -0,0 +1,79 @@
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include "realtime_utilities/parallel_for.h"
+
+// parallel_for nested in the jobs of the same pool must not deadlock: the
+// outer bodies run on the workers, and the inner loops cannot count on
+// helpers queued behind them. A watchdog fails the test if it hangs.
+
+int main(int argc, char* argv[])
+{
+  std::atomic<bool> finished(false);
+  std::thread watchdog([&finished]
+  {
+    for (int i = 0; i < 1000 && !finished; i++)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (!finished)
+    {
+      std::cout << "[ FAILED ] nested parallel_for did not complete in 10 s" << std::endl;
+      std::_Exit(1);
+    }
+  });
+
+  realtime_utilities::tasks pool;
+  pool.start(2);
+
+  for (int round = 0; round < 100; round++)
+  {
+    std::atomic<int> count(0);
+    realtime_utilities::parallel_for(pool, 0, 8, 1, [&](int)
+    {
+      realtime_utilities::parallel_for(pool, 0, 64, 1, [&](int){ count++; });
+    });
+    if (count != 8 * 64)
+    {
+      std::cout << "[ FAILED ] nested parallel_for ran " << count << " bodies instead of " << 8 * 64 << std::endl;
+      return 1;
+    }
+  }
+
+  // the first exception reaches the caller, also from a nested loop
+  bool caught = false;
+  try
+  {
+    realtime_utilities::parallel_for(pool, 0, 8, 1, [&](int i)
+    {
+      realtime_utilities::parallel_for(pool, 0, 16, 1, [&](int j)
+      {
+        if (i == 3 && j == 5)
+          throw std::runtime_error("boom");
+      });
+    });
+  }
+  catch (const std::runtime_error&)
+  {
+    caught = true;
+  }
+  if (!caught)
+  {
+    std::cout << "[ FAILED ] the exception of a nested body was lost" << std::endl;
+    return 1;
+  }
+
+  int sum = realtime_utilities::parallel_reduce(pool, 0, 1000, 0, 0, [](int i){ return i; }, [](int a, int b){ return a + b; });
+  if (sum != 999 * 1000 / 2)
+  {
+    std::cout << "[ FAILED ] parallel_reduce returned " << sum << std::endl;
+    return 1;
+  }
+
+  pool.finish();
+  finished = true;
+  watchdog.join();
+  std::cout << "[ OK ]" << std::endl;
+  return 0;
+}
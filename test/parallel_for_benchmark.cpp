@@ -0,0 +1,43 @@
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <iostream>
+#include "realtime_utilities/parallel_for.h"
+
+// Per-loop overhead of parallel_for: loops of workers + 1 chunks whose body
+// is almost empty, so that the time per loop is the cost of queuing the
+// helpers, handing out the chunks and waiting on the latch. Run it on idle
+// cores: an oversubscribed machine measures the scheduler instead.
+
+int main(int argc, char* argv[])
+{
+  std::size_t loops = argc > 1 ? std::stoul(argv[1]) : 100000;
+  std::size_t max_workers = argc > 2 ? std::stoul(argv[2]) : std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+  std::cout << "loops: " << loops << std::endl;
+  std::cout << "workers      overhead [us/loop]" << std::endl;
+  for (std::size_t n = 1; n <= std::max<std::size_t>(1, max_workers); n++)
+  {
+    realtime_utilities::tasks pool;
+    pool.start(n);
+    pool.set_wait_policy(realtime_utilities::wait_policy{std::chrono::microseconds(50), std::chrono::nanoseconds(0)});
+
+    std::atomic<std::size_t> sink(0);
+    const int chunks = static_cast<int>(n + 1);
+    for (std::size_t i = 0; i < loops / 10; i++)  // warm-up
+    {
+      realtime_utilities::parallel_for(pool, 0, chunks, 1, [&](int j){ sink.fetch_add(j, std::memory_order_relaxed); });
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < loops; i++)
+    {
+      realtime_utilities::parallel_for(pool, 0, chunks, 1, [&](int j){ sink.fetch_add(j, std::memory_order_relaxed); });
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    pool.finish();
+    std::cout << n << "\t\t" << 1e6 * std::chrono::duration<double>(t1 - t0).count() / double(loops) << std::endl;
+  }
+  return 0;
+}
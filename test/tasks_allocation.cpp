@@ -0,0 +1,96 @@
+#include <new>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include "realtime_utilities/parallel_computing.h"
+
+// Counts every heap allocation of the process: after the warm-up, submitting
+// jobs through tasks::submit() and waiting for them must not allocate.
+
+static std::atomic<std::size_t> allocations(0);
+
+void* operator new(std::size_t size)
+{
+  allocations++;
+  void* p = std::malloc(size);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+int main(int argc, char* argv[])
+{
+  realtime_utilities::tasks tasks;
+  tasks.start(2);
+
+  std::atomic<int> counter(0);
+  double payload[4] = {1, 2, 3, 4};
+
+  // warm-up: thread creation, first use of the synchronization primitives
+  for (std::size_t i = 0; i < 16; i++)
+  {
+    tasks.submit([&counter]{ counter++; }).wait();
+  }
+
+  std::size_t before = allocations.load();
+  for (std::size_t i = 0; i < 1000; i++)
+  {
+    realtime_utilities::task_handle h1 = tasks.submit([&counter]{ counter++; });
+    realtime_utilities::task_handle h2 = tasks.submit([&counter, payload]{ counter += int(payload[3]); });
+    realtime_utilities::task_handle h3 = tasks.submit([&counter]{ counter++; }, realtime_utilities::PRIORITY_HIGH);
+    tasks.execute([&counter]{ counter++; });
+    h1.wait();
+    h2.get();
+    h3.get();
+  }
+  std::size_t after = allocations.load();
+
+  tasks.finish();
+
+  std::cout << "allocations during steady-state submission: " << after - before << std::endl;
+  if (after != before)
+  {
+    std::cout << "[ FAILED ] tasks::submit() allocated on the heap" << std::endl;
+    return 1;
+  }
+
+  // a cancelled job never runs, and its handle reports a broken promise
+  {
+    realtime_utilities::tasks idle;  // no worker: the job stays queued
+    bool ran = false;
+    realtime_utilities::task_handle h = idle.submit([&ran]{ ran = true; });
+    idle.cancel_pending();
+    bool broken = false;
+    try
+    {
+      h.get();
+    }
+    catch (const std::future_error& e)
+    {
+      broken = e.code() == std::future_errc::broken_promise;
+    }
+    if (ran || !broken)
+    {
+      std::cout << "[ FAILED ] task_handle::get() of a cancelled job did not throw broken_promise" << std::endl;
+      return 1;
+    }
+    idle.finish();
+    if (idle.submit([]{}).valid())
+    {
+      std::cout << "[ FAILED ] tasks::submit() accepted a job after finish()" << std::endl;
+      return 1;
+    }
+  }
+  std::cout << "[ OK ]" << std::endl;
+  return 0;
+}
@@ -0,0 +1,47 @@
+#include <cstdio>
+#include <cstdlib>
+#include <sched.h>
+#include "realtime_utilities/realtime_utilities.h"
+
+// Wake-up latency of a periodic thread, like cyclictest: the thread waits
+// with timer_wait_rest_of_period() and a wakeup_recorder records how late it
+// wakes up with respect to next_period.
+//
+//   wakeup_latency [period_us=1000] [duration_s=10] [prio=80]
+//
+// Run with the RT privileges (or as root) to have SCHED_FIFO.
+
+int main(int argc, char* argv[])
+{
+  const long   period_us  = argc > 1 ? std::atol(argv[1]) : 1000;
+  const double duration_s = argc > 2 ? std::atof(argv[2]) : 10.0;
+  const int    prio       = argc > 3 ? std::atoi(argv[3]) : 80;
+  if (period_us <= 0 || duration_s <= 0)
+  {
+    printf("usage: %s [period_us] [duration_s] [prio]\n", argv[0]);
+    return 1;
+  }
+
+  if (!realtime_utilities::setprio(prio, SCHED_FIFO))
+  {
+    printf("SCHED_FIFO priority %d not allowed, measuring with the default scheduling.\n", prio);
+  }
+
+  realtime_utilities::wakeup_recorder recorder;
+  realtime_utilities::period_info pinfo;
+  realtime_utilities::timer_periodic_init(&pinfo, period_us * 1000);
+  const std::size_t cycles = std::size_t(duration_s * 1e6 / period_us);
+  for (std::size_t i = 0; i < cycles; i++)
+  {
+    realtime_utilities::timer_inc_period(&pinfo);
+    realtime_utilities::timer_wait_rest_of_period(&pinfo.next_period, &recorder);
+  }
+
+  const realtime_utilities::wakeup_stats s = recorder.statistics();
+  printf("period %ld us, %zu cycles\n", period_us, cycles);
+  printf("wake-up latency [us]: min %.1f avg %.1f p50 %.1f p99 %.1f p99.9 %.1f max %.1f\n",
+         1e-3 * s.latency.min, 1e-3 * s.latency.mean, 1e-3 * s.latency.p50,
+         1e-3 * s.latency.p99, 1e-3 * s.latency.p999, 1e-3 * s.latency.max);
+  printf("overruns: %zu\n", s.overruns);
+  return 0;
+}
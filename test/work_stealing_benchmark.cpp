@@ -0,0 +1,61 @@
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include "realtime_utilities/parallel_computing.h"
+#include "realtime_utilities/work_stealing_tasks.h"
+
+// Fine grained jobs (a few microseconds each, like the per-joint dynamics)
+// queued from the main thread: throughput of the FIFO pool and of the
+// work-stealing pool, from 1 to N workers.
+
+static double job(std::size_t i)
+{
+  double acc = 0;
+  for (std::size_t k = 0; k < 200; k++)
+  {
+    acc += std::sin(double(i + k));
+  }
+  return acc;
+}
+
+template<typename Pool>
+double run(std::size_t workers, std::size_t jobs)
+{
+  Pool pool;
+  pool.start(workers);
+
+  std::vector< std::future<double> > res;
+  res.reserve(jobs);
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < jobs; i++)
+  {
+    res.push_back(pool.queue([i]{ return job(i); }));
+  }
+  for (auto & r : res)
+  {
+    r.get();
+  }
+  auto t1 = std::chrono::steady_clock::now();
+
+  pool.finish();
+  return std::chrono::duration<double>(t1 - t0).count();
+}
+
+int main(int argc, char* argv[])
+{
+  std::size_t jobs = argc > 1 ? std::stoul(argv[1]) : 200000;
+  std::size_t max_workers = argc > 2 ? std::stoul(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+
+  std::cout << "jobs: " << jobs << std::endl;
+  std::cout << "workers      tasks [jobs/s]   work_stealing_tasks [jobs/s]" << std::endl;
+  for (std::size_t n = 1; n <= max_workers; n++)
+  {
+    double fifo = run<realtime_utilities::tasks>(n, jobs);
+    double ws   = run<realtime_utilities::work_stealing_tasks>(n, jobs);
+    std::cout << n << "\t\t" << size_t(jobs / fifo) << "\t\t" << size_t(jobs / ws) << std::endl;
+  }
+  return 0;
+}